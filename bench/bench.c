@@ -0,0 +1,575 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+// Banco de pruebas de sysarena frente a malloc de glibc:
+//   sysarena_bench [micro] [mt] [trace FICHERO]...   (sin argumentos: todo)
+
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sysarena.h"
+
+#define LIVE_SLOTS 8192
+#define THROUGHPUT_OPS 2000000
+#define LATENCY_OPS 400000
+#define SAMPLE_EVERY 256
+#define MT_OPS 1000000
+#define MT_MAX_THREADS 8
+#define BUDDY_REGION ((size_t)1 << 30)
+#define BUDDY_TABLE ((size_t)1 << 16)
+#define VM_RESERVE ((size_t)8 << 30)
+#define DEFAULT_TRACE "bench/traces/sample.trace"
+
+// ---- Asignadores comparados ----
+
+typedef struct Allocator {
+    const char *name;
+    bool (*setup)(void);
+    void (*teardown)(void);
+    void *(*alloc)(size_t size);
+    void (*free)(void *ptr);
+    void *(*realloc)(void *ptr, size_t size);
+    size_t (*footprint)(void);
+} Allocator;
+
+static ArenaManager manager;
+static uint8_t *buddy_memory;
+static Arena *buddy_table;
+static size_t malloc_baseline;
+
+static void *map(size_t size) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static void *sa_alloc(size_t size) { return sysarena_alloc(&manager, size); }
+static void sa_free(void *ptr) { sysarena_free(&manager, ptr); }
+static void *sa_realloc(void *ptr, size_t size) { return sysarena_realloc(&manager, ptr, size); }
+
+// Búfer fijo: la región hasta el último bloque ocupado más la tabla entera (init la recorre)
+static size_t sa_footprint(void) {
+    size_t end = 0;
+    for (Arena *a = &manager.arenas[0]; a; a = a->next) {
+        if (a->in_use) end = (size_t)((uint8_t*)a->base + a->size - manager.initial_memory);
+    }
+    return end + manager.max_arenas * sizeof(Arena);
+}
+
+// Respaldo virtual: memoria accesible ahora mismo más las entradas de la tabla ya creadas
+static size_t vm_footprint(void) {
+    return manager.committed + manager.max_arenas * sizeof(Arena);
+}
+
+static bool bins_setup(void) { return sysarena_init_vm(&manager, VM_RESERVE, SYSARENA_THREAD_SAFE); }
+static void bins_teardown(void) { sysarena_vm_destroy(&manager); }
+
+static bool buddy_setup(void) {
+    if (!buddy_memory) buddy_memory = map(BUDDY_REGION);
+    if (!buddy_table) buddy_table = map(BUDDY_TABLE * sizeof(Arena));
+    return buddy_memory && buddy_table &&
+           sysarena_init_ex(&manager, buddy_memory, buddy_table, BUDDY_REGION, BUDDY_TABLE,
+                            SYSARENA_ENGINE_BUDDY | SYSARENA_THREAD_SAFE);
+}
+static void buddy_teardown(void) {
+    madvise(buddy_memory, BUDDY_REGION, MADV_DONTNEED);
+}
+
+static size_t malloc_heap(void) {
+    struct mallinfo2 info = mallinfo2();
+    return info.arena + info.hblkhd;
+}
+static bool libc_setup(void) {
+    malloc_trim(0);
+    malloc_baseline = malloc_heap();
+    return true;
+}
+static void libc_teardown(void) { malloc_trim(0); }
+static size_t libc_footprint(void) {
+    size_t heap = malloc_heap();
+    return heap > malloc_baseline ? heap - malloc_baseline : 0;
+}
+
+static const Allocator allocators[] = {
+    { "sysarena", bins_setup, bins_teardown, sa_alloc, sa_free, sa_realloc, vm_footprint },
+    { "sysarena-buddy", buddy_setup, buddy_teardown, sa_alloc, sa_free, sa_realloc, sa_footprint },
+    { "glibc-malloc", libc_setup, libc_teardown, malloc, free, realloc, libc_footprint },
+};
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+// ---- Utilidades de medida ----
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct Report {
+    double ops_per_sec;
+    uint64_t p50, p99, p999;
+    size_t peak_footprint;
+    size_t live_at_peak;
+    size_t failures; // Reservas fallidas de la pasada de rendimiento
+    bool detailed;   // Hay latencias y huella (el churn multihilo solo mide ops/s)
+} Report;
+
+static void print_header(void) {
+    printf("%-22s %-15s %12s %8s %8s %8s %12s %6s %6s\n",
+           "workload", "allocator", "ops/s", "p50 ns", "p99 ns", "p999 ns", "peak KiB", "frag", "fail");
+}
+
+static void print_report(const char *workload, const char *name, const Report *r) {
+    if (!r->detailed) {
+        printf("%-22s %-15s %12.0f %8s %8s %8s %12s %6s %6zu\n", workload, name, r->ops_per_sec,
+               "-", "-", "-", "-", "-", r->failures);
+        return;
+    }
+    double frag = r->peak_footprint ? 1.0 - (double)r->live_at_peak / (double)r->peak_footprint : 0.0;
+    if (frag < 0) frag = 0;
+    printf("%-22s %-15s %12.0f %8llu %8llu %8llu %12zu %6.3f %6zu\n", workload, name, r->ops_per_sec,
+           (unsigned long long)r->p50, (unsigned long long)r->p99, (unsigned long long)r->p999,
+           r->peak_footprint / 1024, frag, r->failures);
+}
+
+// Convierte las latencias de cada operación en percentiles
+static void percentiles(Report *r, uint64_t *latencies, size_t count) {
+    if (count == 0) return;
+    qsort(latencies, count, sizeof(uint64_t), compare_u64);
+    r->p50 = latencies[count / 2];
+    r->p99 = latencies[count * 99 / 100];
+    r->p999 = latencies[count * 999 / 1000];
+}
+
+// Ejecuta fn en un proceso hijo: malloc no devuelve su montículo, así que la
+// huella de cada pasada solo es comparable partiendo de un proceso sin usar
+static void in_child(void (*fn)(void *), void *arg) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn(arg);
+        fflush(stdout);
+        _exit(0);
+    }
+    if (pid > 0) waitpid(pid, NULL, 0);
+}
+
+// ---- Microbenchmarks por distribución de tamaños ----
+
+typedef struct Distribution {
+    const char *name;
+    size_t min, max;
+    bool log_uniform;
+} Distribution;
+
+static const Distribution distributions[] = {
+    { "micro/small-16-128", 16, 128, false },
+    { "micro/mixed-16-4k", 16, 4096, true },
+    { "micro/large-4k-64k", 4096, 65536, false },
+};
+
+static size_t draw_size(const Distribution *d, uint64_t *rng) {
+    if (!d->log_uniform) return d->min + xorshift(rng) % (d->max - d->min + 1);
+    size_t lo = 63 - (size_t)__builtin_clzll(d->min), hi = 63 - (size_t)__builtin_clzll(d->max);
+    size_t order = lo + xorshift(rng) % (hi - lo + 1);
+    size_t size = ((size_t)1 << order) + xorshift(rng) % ((size_t)1 << order);
+    return size > d->max ? d->max : size;
+}
+
+typedef struct MicroRun {
+    const Allocator *allocator;
+    const Distribution *distribution;
+    void **slots;
+    size_t *sizes;
+    uint64_t *latencies;
+    Report report;
+} MicroRun;
+
+// Pasada de latencia y huella, desde un asignador recién preparado
+static void micro_latency(void *arg) {
+    MicroRun *run = arg;
+    const Allocator *a = run->allocator;
+    Report *r = &run->report;
+    void **slots = run->slots;
+    size_t *sizes = run->sizes;
+    uint64_t *latencies = run->latencies;
+    if (!a->setup()) return;
+
+    uint64_t rng = 0xD1B54A32D192ED03ull;
+    size_t live = 0;
+    r->detailed = true;
+    memset(slots, 0, LIVE_SLOTS * sizeof(void*));
+    for (size_t i = 0; i < LATENCY_OPS; i++) {
+        size_t k = xorshift(&rng) % LIVE_SLOTS;
+        uint64_t t0;
+        if (slots[k]) {
+            t0 = now_ns();
+            a->free(slots[k]);
+            latencies[i] = now_ns() - t0;
+            live -= sizes[k];
+            slots[k] = NULL;
+        } else {
+            size_t size = draw_size(run->distribution, &rng);
+            t0 = now_ns();
+            slots[k] = a->alloc(size);
+            latencies[i] = now_ns() - t0;
+            if (slots[k]) {
+                sizes[k] = size;
+                live += size;
+            }
+        }
+        if (i % SAMPLE_EVERY == 0) {
+            size_t footprint = a->footprint();
+            if (footprint > r->peak_footprint) {
+                r->peak_footprint = footprint;
+                r->live_at_peak = live;
+            }
+        }
+    }
+    for (size_t k = 0; k < LIVE_SLOTS; k++) {
+        if (slots[k]) a->free(slots[k]);
+    }
+    percentiles(r, latencies, LATENCY_OPS);
+    print_report(run->distribution->name, a->name, r);
+    a->teardown();
+}
+
+// Pasada de rendimiento: sin medir cada operación
+static void micro_throughput(void *arg) {
+    MicroRun *run = arg;
+    const Allocator *a = run->allocator;
+    void **slots = run->slots;
+    size_t failures = 0;
+    if (!a->setup()) return;
+
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    memset(slots, 0, LIVE_SLOTS * sizeof(void*));
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < THROUGHPUT_OPS; i++) {
+        size_t k = xorshift(&rng) % LIVE_SLOTS;
+        if (slots[k]) {
+            a->free(slots[k]);
+            slots[k] = NULL;
+        } else {
+            slots[k] = a->alloc(draw_size(run->distribution, &rng));
+            if (!slots[k]) failures++;
+        }
+    }
+    run->report.ops_per_sec = THROUGHPUT_OPS / ((now_ns() - start) / 1e9);
+    run->report.failures = failures;
+    for (size_t k = 0; k < LIVE_SLOTS; k++) {
+        if (slots[k]) a->free(slots[k]);
+    }
+    a->teardown();
+}
+
+static void run_micro(const Allocator *a, const Distribution *d, void **slots, size_t *sizes, uint64_t *latencies) {
+    // Compartido con los hijos: el de rendimiento deja ahí sus cifras para el de latencia
+    MicroRun *run = mmap(NULL, sizeof(MicroRun), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (run == MAP_FAILED) return;
+    memset(run, 0, sizeof(MicroRun));
+    run->allocator = a;
+    run->distribution = d;
+    run->slots = slots;
+    run->sizes = sizes;
+    run->latencies = latencies;
+    in_child(micro_throughput, run);
+    in_child(micro_latency, run);
+    munmap(run, sizeof(MicroRun));
+}
+
+// ---- Churn multihilo ----
+
+typedef struct Worker {
+    const Allocator *allocator;
+    bool use_cache;
+    size_t ops;
+    size_t failures;
+    uint64_t seed;
+} Worker;
+
+static void *mt_worker(void *arg) {
+    Worker *w = arg;
+    void *slots[1024] = { 0 };
+    ArenaThreadCache cache;
+    if (w->use_cache) sysarena_cache_init(&cache, &manager);
+    uint64_t rng = w->seed;
+
+    for (size_t i = 0; i < w->ops; i++) {
+        size_t k = xorshift(&rng) % 1024;
+        if (slots[k]) {
+            if (w->use_cache) sysarena_cache_free(&cache, slots[k]);
+            else w->allocator->free(slots[k]);
+            slots[k] = NULL;
+        } else {
+            size_t size = 16 + xorshift(&rng) % 512;
+            slots[k] = w->use_cache ? sysarena_cache_alloc(&cache, size) : w->allocator->alloc(size);
+            if (!slots[k]) w->failures++;
+        }
+    }
+    for (size_t k = 0; k < 1024; k++) {
+        if (!slots[k]) continue;
+        if (w->use_cache) sysarena_cache_free(&cache, slots[k]);
+        else w->allocator->free(slots[k]);
+    }
+    if (w->use_cache) sysarena_cache_destroy(&cache);
+    return NULL;
+}
+
+static void run_mt(const Allocator *a, const char *name, bool use_cache, int threads) {
+    Report r = { 0 };
+    char workload[32];
+    snprintf(workload, sizeof(workload), "mt/churn-%dt", threads);
+    if (!a->setup()) return;
+
+    pthread_t tids[MT_MAX_THREADS];
+    Worker workers[MT_MAX_THREADS];
+    uint64_t start = now_ns();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){ a, use_cache, MT_OPS / (size_t)threads, 0, 0x2545F4914F6CDD1Dull + (uint64_t)t };
+        pthread_create(&tids[t], NULL, mt_worker, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        r.failures += workers[t].failures;
+    }
+    r.ops_per_sec = MT_OPS / ((now_ns() - start) / 1e9);
+    print_report(workload, name, &r);
+    a->teardown();
+}
+
+// ---- Reproducción de trazas ----
+// Formato de texto, una operación por línea ('#' comenta):
+//   a <id> <tamaño>   reservar
+//   f <id>            liberar
+//   r <id> <tamaño>   cambiar de tamaño
+
+typedef struct TraceOp {
+    char op;
+    size_t id;
+    size_t size;
+} TraceOp;
+
+static TraceOp *load_trace(const char *path, size_t *count, size_t *max_id) {
+    FILE *file = fopen(path, "r");
+    if (!file) return NULL;
+    size_t capacity = 1024, n = 0;
+    TraceOp *ops = malloc(capacity * sizeof(TraceOp));
+    char line[128];
+    *max_id = 0;
+    while (ops && fgets(line, sizeof(line), file)) {
+        TraceOp op = { 0 };
+        int fields = sscanf(line, " %c %zu %zu", &op.op, &op.id, &op.size);
+        if (fields < 2 || op.op == '#') continue;
+        if ((op.op == 'a' || op.op == 'r') && fields < 3) continue;
+        if (n == capacity) {
+            capacity *= 2;
+            TraceOp *grown = realloc(ops, capacity * sizeof(TraceOp));
+            if (!grown) break;
+            ops = grown;
+        }
+        ops[n++] = op;
+        if (op.id > *max_id) *max_id = op.id;
+    }
+    fclose(file);
+    *count = n;
+    return ops;
+}
+
+typedef struct TraceRun {
+    const Allocator *allocator;
+    const char *path;
+    const TraceOp *ops;
+    size_t count;
+    size_t max_id;
+    uint64_t *latencies;
+    Report report;
+} TraceRun;
+
+// Aplica una operación de la traza; false si una reserva o un cambio de tamaño falló
+static bool trace_step(const Allocator *a, void **ptrs, const TraceOp *op) {
+    switch (op->op) {
+    case 'a':
+        if (ptrs[op->id]) a->free(ptrs[op->id]);
+        ptrs[op->id] = a->alloc(op->size);
+        break;
+    case 'f':
+        a->free(ptrs[op->id]);
+        ptrs[op->id] = NULL;
+        return true;
+    case 'r': {
+        void *moved = a->realloc(ptrs[op->id], op->size);
+        if (moved || op->size == 0) ptrs[op->id] = moved;
+        break;
+    }
+    }
+    return ptrs[op->id] || op->size == 0;
+}
+
+// Pasada de rendimiento: la traza entera sin medir cada operación
+static void trace_throughput(void *arg) {
+    TraceRun *run = arg;
+    const Allocator *a = run->allocator;
+    size_t failures = 0;
+    void **ptrs = map((run->max_id + 1) * sizeof(void*));
+    if (!ptrs || !a->setup()) return;
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < run->count; i++) {
+        if (!trace_step(a, ptrs, &run->ops[i])) failures++;
+    }
+    run->report.ops_per_sec = run->count / ((now_ns() - start) / 1e9);
+    run->report.failures = failures;
+    for (size_t id = 0; id <= run->max_id; id++) {
+        if (ptrs[id]) a->free(ptrs[id]);
+    }
+    a->teardown();
+    munmap(ptrs, (run->max_id + 1) * sizeof(void*));
+}
+
+// Pasada de latencia y huella; ops/s y fallos vienen de la de rendimiento
+static void trace_latency(void *arg) {
+    TraceRun *run = arg;
+    const Allocator *a = run->allocator;
+    const TraceOp *ops = run->ops;
+    size_t count = run->count, max_id = run->max_id;
+    uint64_t *latencies = run->latencies;
+    Report *r = &run->report;
+    void **ptrs = map((max_id + 1) * sizeof(void*));
+    size_t *sizes = map((max_id + 1) * sizeof(size_t));
+    uint64_t *trace_latencies = count <= LATENCY_OPS ? latencies : map(count * sizeof(uint64_t));
+    if (!ptrs || !sizes || !trace_latencies || !a->setup()) return;
+
+    size_t live = 0;
+    r->detailed = true;
+    for (size_t i = 0; i < count; i++) {
+        const TraceOp *op = &ops[i];
+        uint64_t t0 = now_ns();
+        trace_step(a, ptrs, op);
+        trace_latencies[i] = now_ns() - t0;
+
+        live -= sizes[op->id];
+        sizes[op->id] = ptrs[op->id] ? op->size : 0;
+        live += sizes[op->id];
+        if (i % SAMPLE_EVERY == 0) {
+            size_t footprint = a->footprint();
+            if (footprint > r->peak_footprint) {
+                r->peak_footprint = footprint;
+                r->live_at_peak = live;
+            }
+        }
+    }
+    for (size_t id = 0; id <= max_id; id++) {
+        if (ptrs[id]) a->free(ptrs[id]);
+    }
+    percentiles(r, trace_latencies, count);
+
+    const char *base = strrchr(run->path, '/');
+    char workload[64];
+    snprintf(workload, sizeof(workload), "trace/%s", base ? base + 1 : run->path);
+    print_report(workload, a->name, r);
+    a->teardown();
+
+    munmap(ptrs, (max_id + 1) * sizeof(void*));
+    munmap(sizes, (max_id + 1) * sizeof(size_t));
+    if (trace_latencies != latencies) munmap(trace_latencies, count * sizeof(uint64_t));
+}
+
+static void bench_micro(void **slots, size_t *sizes, uint64_t *latencies) {
+    for (size_t d = 0; d < sizeof(distributions) / sizeof(distributions[0]); d++) {
+        for (size_t a = 0; a < NUM_ALLOCATORS; a++) {
+            run_micro(&allocators[a], &distributions[d], slots, sizes, latencies);
+        }
+    }
+}
+
+static void bench_mt(void) {
+    for (int threads = 1; threads <= MT_MAX_THREADS; threads *= 2) {
+        run_mt(&allocators[0], "sysarena", false, threads);
+        run_mt(&allocators[0], "sysarena-cache", true, threads);
+        run_mt(&allocators[2], "glibc-malloc", false, threads);
+    }
+}
+
+static bool bench_trace(const char *path, uint64_t *latencies) {
+    size_t count, max_id;
+    TraceOp *ops = load_trace(path, &count, &max_id);
+    if (!ops) {
+        fprintf(stderr, "cannot read trace %s\n", path);
+        return false;
+    }
+    // Compartido con los hijos, como en run_micro
+    TraceRun *run = mmap(NULL, sizeof(TraceRun), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (run == MAP_FAILED) {
+        free(ops);
+        return false;
+    }
+    for (size_t a = 0; a < NUM_ALLOCATORS; a++) {
+        *run = (TraceRun){ .allocator = &allocators[a], .path = path, .ops = ops, .count = count,
+                           .max_id = max_id, .latencies = latencies };
+        in_child(trace_throughput, run);
+        in_child(trace_latency, run);
+    }
+    munmap(run, sizeof(TraceRun));
+    free(ops);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    // Los datos del propio banco van en mmap para no ensuciar la huella de malloc
+    void **slots = map(LIVE_SLOTS * sizeof(void*));
+    size_t *sizes = map(LIVE_SLOTS * sizeof(size_t));
+    uint64_t *latencies = map(LATENCY_OPS * sizeof(uint64_t));
+    if (!slots || !sizes || !latencies) return 1;
+
+    print_header();
+    if (argc < 2) {
+        bench_micro(slots, sizes, latencies);
+        bench_mt();
+        return bench_trace(DEFAULT_TRACE, latencies) ? 0 : 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "micro")) {
+            bench_micro(slots, sizes, latencies);
+        } else if (!strcmp(argv[i], "mt")) {
+            bench_mt();
+        } else if (!strcmp(argv[i], "trace") && i + 1 < argc) {
+            if (!bench_trace(argv[++i], latencies)) return 1;
+        } else {
+            fprintf(stderr, "usage: %s [micro] [mt] [trace FILE]...\n", argv[0]);
+            return 1;
+        }
+    }
+    return 0;
+}
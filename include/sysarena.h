@@ -17,33 +17,184 @@
 
 #include "types.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Número de cajones por clase de tamaño (uno por potencia de dos)
+#define SYSARENA_BINS 64
+
+// Alineación mínima de todo bloque devuelto (la de max_align_t)
+#ifdef __cplusplus
+#define SYSARENA_ALIGNMENT alignof(max_align_t)
+#else
+#define SYSARENA_ALIGNMENT _Alignof(max_align_t)
+#endif
+
+// Línea de caché para bloques calientes que no deben compartirse entre hilos
+#define SYSARENA_CACHE_LINE 64
+
+// Opciones de sysarena_init_ex
+#define SYSARENA_THREAD_SAFE 0x1u  // Proteger el gestor con un cerrojo
+#define SYSARENA_ENGINE_BUDDY 0x2u // Motor buddy en lugar de cajones por tamaño
+
+// Políticas de fusión de bloques libres (sysarena_set_coalesce)
+#define SYSARENA_COALESCE_EAGER 0u       // Con sus vecinos en cada free (por defecto)
+#define SYSARENA_COALESCE_DEFERRED 1u    // Pasada completa cada param frees o al fallar una reserva
+#define SYSARENA_COALESCE_INCREMENTAL 2u // Como mucho param pasos de fusión por free
+
+// Cachés por hilo: clases de 16 << i bytes
+#define SYSARENA_CACHE_CLASSES 8   // De 16 a 2048 bytes
+#define SYSARENA_CACHE_BATCH 16    // Bloques que se piden o devuelven de una vez
+#define SYSARENA_CACHE_DEPTH 64    // Máximo de bloques guardados por clase
+
+struct ArenaManager;
+struct ArenaThreadCache;
+
 typedef struct Arena {
     size_t size;         // Tamaño total del bloque
     ptr_t base;          // Puntero al inicio del bloque
     size_t used;         // Bytes usados en el bloque
     bool in_use;         // ¿Bloque ocupado?
     bool is_contiguous;  // ¿Es contiguo para fusionar?
+    struct Arena *prev;      // Bloque físicamente anterior
+    struct Arena *next;      // Bloque físicamente siguiente (o siguiente hueco libre de la tabla)
+    struct Arena *prev_free; // Anterior en la lista de su cajón
+    struct Arena *next_free; // Siguiente en la lista de su cajón
 } Arena;
 
+// Contadores del gestor; solo se actualizan si la biblioteca se compila con SYSARENA_STATS
+typedef struct ArenaStats {
+    size_t allocs;          // Reservas servidas
+    size_t frees;           // Liberaciones
+    size_t failed_allocs;   // Reservas que devolvieron NULL
+    size_t table_exhausted; // Veces que no quedaba entrada libre en la tabla para partir un bloque
+    size_t bytes_in_use;    // Bytes de bloques ocupados (cabecera incluida)
+    size_t peak_bytes;      // Máximo de bytes_in_use
+    size_t splits;          // Bloques partidos
+    size_t merges;          // Bloques fusionados
+    size_t live_entries;    // Entradas de la tabla con bloque
+    size_t largest_free;    // Mayor bloque libre (calculado al pedir las estadísticas)
+} ArenaStats;
+
+// Foto de la disposición de bloques, con histograma de huecos libres
+typedef struct ArenaSnapshot {
+    size_t blocks;                    // Bloques en la cadena física
+    size_t used_blocks;               // Bloques ocupados
+    size_t used_bytes;                // Bytes en bloques ocupados
+    size_t free_bytes;                // Bytes en bloques libres
+    size_t largest_free;              // Mayor bloque libre
+    size_t spare_entries;             // Entradas de la tabla sin bloque
+    size_t free_histogram[SYSARENA_BINS]; // Bloques libres por floor(log2(tamaño))
+} ArenaSnapshot;
+
+// Respaldo de la memoria del gestor (NULL: búfer fijo del llamante)
+typedef struct ArenaBackend {
+    bool (*commit)(struct ArenaManager *manager, uint8_t *end);  // Hacer accesible la memoria hasta end
+    bool (*grow_table)(struct ArenaManager *manager);            // Añadir entradas libres a la tabla
+    void (*release)(struct ArenaManager *manager, Arena *block); // Un bloque acaba de quedar libre
+    void (*yield)(void);                                         // Ceder la CPU si el cerrojo tarda (opcional)
+} ArenaBackend;
+
 typedef struct ArenaManager {
     Arena* arenas;            // Array de arenas (bloques)
     size_t max_arenas;        // Número total de arenas
     uint8_t *initial_memory;  // Memoria inicial global
     size_t initial_size;      // Tamaño inicial global
     size_t current_arena_idx; // No es crítico para el modelo génesis, pero puede usarse
+    Arena *spare;             // Huecos de la tabla sin bloque asignado
+    Arena *bins[SYSARENA_BINS]; // Bloques libres por clase de tamaño (floor(log2(size)))
+    uint64_t bin_map;         // Bit i activo si bins[i] no está vacío
+    unsigned flags;           // Opciones SYSARENA_* de sysarena_init_ex
+    bool lock;                // Cerrojo del modo SYSARENA_THREAD_SAFE
+    const ArenaBackend *backend; // Respaldo de memoria (NULL si es un búfer fijo)
+    size_t committed;         // Bytes de initial_memory accesibles ahora mismo
+    size_t table_capacity;    // Entradas que puede llegar a tener la tabla
+    ArenaStats stats;         // Contadores (con SYSARENA_STATS)
+    unsigned coalesce;        // Política SYSARENA_COALESCE_*
+    size_t coalesce_param;    // Umbral de frees (diferida) o pasos por llamada (incremental)
+    size_t pending_frees;     // Frees sin fusionar desde la última pasada (diferida)
+    Arena *merge_cursor;      // Por dónde va la fusión incremental
+    struct ArenaThreadCache *caches; // Cachés vivas (las liberaciones remotas solo van a estas)
 } ArenaManager;
 
+// Caché de bloques libres de un hilo (cada hilo tiene la suya, p. ej. _Thread_local)
+typedef struct ArenaThreadCache {
+    ArenaManager *manager;                     // Gestor compartido (en modo SYSARENA_THREAD_SAFE)
+    void *free_lists[SYSARENA_CACHE_CLASSES];  // Bloques libres por clase, enlazados en su cuerpo
+    size_t counts[SYSARENA_CACHE_CLASSES];     // Bloques en cada lista
+    void *remote;                              // Pila MPSC: liberaciones de otros hilos
+    struct ArenaThreadCache *next;             // Siguiente caché viva del gestor
+} ArenaThreadCache;
+
+// Slab de objetos de tamaño fijo tallados en trozos grandes pedidos al gestor
+typedef struct ArenaSlab {
+    ArenaManager *manager;     // Gestor del que salen los trozos
+    size_t object_size;        // Tamaño de cada objeto (redondeado a la alineación)
+    size_t objects_per_chunk;  // Objetos por trozo
+    void *free_list;           // Objetos libres, enlazados en su cuerpo
+    void *chunks;              // Trozos pedidos, enlazados por su primera palabra
+} ArenaSlab;
+
+// Arena temporal: bump allocator que crece encadenando trozos pedidos al gestor
+struct ArenaScratchChunk;
+
+typedef struct ArenaScratch {
+    ArenaManager *manager;             // Gestor del que salen los trozos
+    size_t chunk_size;                 // Tamaño mínimo de cada trozo
+    struct ArenaScratchChunk *first;   // Primer trozo de la cadena
+    struct ArenaScratchChunk *current; // Trozo en el que se reserva ahora
+} ArenaScratch;
+
+// Punto de control de una arena temporal
+typedef struct ArenaScratchMark {
+    struct ArenaScratchChunk *chunk;
+    size_t used;
+} ArenaScratchMark;
+
 // Inicialización
 bool sysarena_init(ArenaManager *manager, uint8_t *memory, Arena *arenas, size_t total_size, size_t num_arenas);
 
+// Inicialización con opciones (SYSARENA_THREAD_SAFE, SYSARENA_ENGINE_BUDDY, ...)
+bool sysarena_init_ex(ArenaManager *manager, uint8_t *memory, Arena *arenas, size_t total_size, size_t num_arenas, unsigned flags);
+
+#ifdef __linux__
+// Gestor respaldado por memoria virtual (Linux): reserva reserve_size bytes con
+// mmap(PROT_NONE), los hace accesibles según se usan y hace crecer la tabla sola
+bool sysarena_init_vm(ArenaManager *manager, size_t reserve_size, unsigned flags);
+// Devolver al sistema las páginas de todos los bloques libres; devuelve los bytes liberados
+size_t sysarena_vm_trim(ArenaManager *manager);
+// Liberar la reserva entera
+void sysarena_vm_destroy(ArenaManager *manager);
+#endif
+
 // Reservar memoria según el sistema génesis
 void* sysarena_alloc(ArenaManager *manager, size_t size);
 
-// Liberar un bloque entero
+// Reservar con alineación explícita (potencia de dos)
+void* sysarena_alloc_aligned(ArenaManager *manager, size_t size, size_t alignment);
+
+// Reservar ocupando líneas de caché completas (sin compartirlas con otros bloques)
+void* sysarena_alloc_cacheline(ArenaManager *manager, size_t size);
+
+// Cambiar el tamaño de un bloque: crece sobre el vecino libre o encoge en su sitio,
+// y solo copia si no hay otra opción (al mover, la alineación extra de sysarena_alloc_aligned no se conserva)
+void* sysarena_realloc(ArenaManager *manager, void *ptr, size_t size);
+// Igual, pero si hay que mover el bloque el nuevo queda alineado a alignment (potencia de dos)
+void* sysarena_realloc_aligned(ArenaManager *manager, void *ptr, size_t size, size_t alignment);
+
+// Liberar un bloque entero (ptr debe ser el devuelto por sysarena_alloc*)
 bool sysarena_free(ArenaManager *manager, void *ptr);
 
+// Reservar count bloques de size bytes troceando una sola región; devuelve cuántos hay en out
+size_t sysarena_alloc_batch(ArenaManager *manager, size_t size, size_t count, void **out);
+// Liberar count bloques fusionando una vez por racha contigua; devuelve cuántos se liberaron
+size_t sysarena_free_batch(ArenaManager *manager, void **ptrs, size_t count);
+
 // Fusionar arenas libres y contiguas
 void sysarena_defragment(ArenaManager *manager);
+// Elegir la política de fusión; el motor buddy solo admite SYSARENA_COALESCE_EAGER
+bool sysarena_set_coalesce(ArenaManager *manager, unsigned mode, size_t param);
 
 // Inicializar arena vacía
 void poor_arena_init(Arena *arena);
@@ -51,13 +202,59 @@ void poor_arena_init(Arena *arena);
 // Inicializar arena con datos
 bool arena_init(Arena *arena, size_t size, ptr_t base);
 
+// Arena simple como bump allocator (no usar sobre las entradas de un gestor)
+void* arena_alloc(Arena *arena, size_t size); // reservar memoria
+void arena_free(Arena *arena); // liberar toda la arena en O(1)
+
 // Utilidades (pueden mantenerse por compatibilidad)
 void copy_arena(Arena *dest, const Arena *src);
 bool arena_can_merge(const Arena *a, const Arena *b);
 bool arena_is_void(const Arena *a);
 bool arena_merge(Arena *dest, Arena *src);
+// Abre una entrada vacía justo detrás de arenas[where] en la cadena física (O(1))
 void sysarena_displacement(ArenaManager *manager, size_t where);
+// Parte arenas[index]: conserva size bytes y el resto queda como bloque libre (O(1))
 bool sysarena_split(ArenaManager *manager, size_t index, size_t size);
 bool sysarena_is_fully_merged(ArenaManager *manager);
 
+// Estadísticas: copia de los contadores (lecturas relajadas, sin cerrojo)
+void sysarena_get_stats(ArenaManager *manager, ArenaStats *stats);
+// Recorre la cadena física y resume su fragmentación
+bool sysarena_snapshot(ArenaManager *manager, ArenaSnapshot *snapshot);
+// Llama a visit con cada bloque en orden físico (para volcarlos)
+void sysarena_walk(ArenaManager *manager, void (*visit)(const Arena *block, void *context), void *context);
+
+// Cachés por hilo
+void sysarena_cache_init(ArenaThreadCache *cache, ArenaManager *manager);
+// Reservar desde la caché del hilo; solo toma el cerrojo para rellenar por lotes
+void* sysarena_cache_alloc(ArenaThreadCache *cache, size_t size);
+// Liberar cualquier bloque del gestor; si es de otro hilo va a su cola remota.
+// Los bloques propios no se validan (camino rápido); el resto se comprueba con el cerrojo
+bool sysarena_cache_free(ArenaThreadCache *cache, void *ptr);
+// Devolver al gestor todo lo guardado; los bloques aún vivos de la caché pasan al gestor
+// cuando se liberen, así que la caché puede destruirse (o salir de ámbito) antes que ellos
+void sysarena_cache_destroy(ArenaThreadCache *cache);
+
+// Slabs (no son seguros entre hilos: uno por hilo o protegido por el llamante)
+bool sysarena_slab_create(ArenaSlab *slab, ArenaManager *manager, size_t object_size, size_t objects_per_chunk);
+void* sysarena_slab_alloc(ArenaSlab *slab);
+void sysarena_slab_free(ArenaSlab *slab, void *ptr);
+// Devolver todos los trozos al gestor (invalida todos los objetos del slab)
+void sysarena_slab_destroy(ArenaSlab *slab);
+
+// Arenas temporales (una por hilo o petición)
+bool sysarena_scratch_init(ArenaScratch *scratch, ArenaManager *manager, size_t chunk_size);
+void* sysarena_scratch_alloc(ArenaScratch *scratch, size_t size);
+ArenaScratchMark sysarena_scratch_mark(const ArenaScratch *scratch);
+// Volver a un punto de control: todo lo reservado después queda liberado (O(1))
+void sysarena_scratch_rewind(ArenaScratch *scratch, ArenaScratchMark mark);
+// Vaciar la arena entera en O(1) conservando sus trozos para reutilizarlos
+void sysarena_scratch_reset(ArenaScratch *scratch);
+// Devolver todos los trozos al gestor
+void sysarena_scratch_release(ArenaScratch *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
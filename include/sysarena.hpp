@@ -0,0 +1,205 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+// Capa C++ (solo cabecera, C++17) sobre la API de sysarena.h
+#ifndef _SYSARENA_HPP
+#define _SYSARENA_HPP
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "sysarena.h"
+
+namespace sysarena {
+
+// Motor del gestor, fijado en tiempo de compilación
+enum class Engine : unsigned {
+    Bins = 0,                      // Cajones por tamaño
+    Buddy = SYSARENA_ENGINE_BUDDY, // Sistema buddy
+};
+
+namespace detail {
+
+// Elige la llamada según la alineación; con alineaciones constantes se resuelve al compilar
+inline void *allocate(ArenaManager *manager, std::size_t size, std::size_t alignment) noexcept {
+    if (size == 0) size = 1;
+    if (alignment <= SYSARENA_ALIGNMENT) return sysarena_alloc(manager, size);
+    return sysarena_alloc_aligned(manager, size, alignment);
+}
+
+} // namespace detail
+
+// Gestor con su memoria y su tabla dentro: puede vivir en almacenamiento estático.
+// Alignment es la alineación de allocate(size) sin alineación explícita
+template <std::size_t Capacity, std::size_t TableSize, std::size_t Alignment = SYSARENA_ALIGNMENT,
+          Engine E = Engine::Bins, bool ThreadSafe = false>
+class StaticManager {
+    static_assert(Capacity >= 2 * SYSARENA_ALIGNMENT, "sysarena: capacidad demasiado pequeña");
+    static_assert(TableSize > 0, "sysarena: la tabla necesita al menos una entrada");
+    static_assert(Alignment >= SYSARENA_ALIGNMENT && (Alignment & (Alignment - 1)) == 0,
+                  "sysarena: la alineación debe ser una potencia de dos >= SYSARENA_ALIGNMENT");
+
+public:
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr std::size_t table_size = TableSize;
+    static constexpr std::size_t alignment = Alignment;
+    static constexpr unsigned flags = static_cast<unsigned>(E) | (ThreadSafe ? SYSARENA_THREAD_SAFE : 0u);
+
+    StaticManager() noexcept {
+        ready_ = sysarena_init_ex(&manager_, memory_, table_, Capacity, TableSize, flags);
+    }
+    // El gestor guarda punteros a su propia memoria: no se copia ni se mueve
+    StaticManager(const StaticManager &) = delete;
+    StaticManager &operator=(const StaticManager &) = delete;
+
+    explicit operator bool() const noexcept { return ready_; }
+    ArenaManager *get() noexcept { return &manager_; }
+    const ArenaManager *get() const noexcept { return &manager_; }
+
+    void *allocate(std::size_t size) noexcept { return detail::allocate(&manager_, size, Alignment); }
+    void *allocate(std::size_t size, std::size_t align) noexcept {
+        return detail::allocate(&manager_, size, align > Alignment ? align : Alignment);
+    }
+    // Si el bloque se mueve, el nuevo conserva Alignment
+    void *reallocate(void *ptr, std::size_t size) noexcept {
+        if (Alignment <= SYSARENA_ALIGNMENT) return sysarena_realloc(&manager_, ptr, size);
+        return sysarena_realloc_aligned(&manager_, ptr, size, Alignment);
+    }
+    bool deallocate(void *ptr) noexcept { return sysarena_free(&manager_, ptr); }
+
+    bool set_coalesce(unsigned mode, std::size_t param) noexcept { return sysarena_set_coalesce(&manager_, mode, param); }
+    void defragment() noexcept { sysarena_defragment(&manager_); }
+
+private:
+    ArenaManager manager_;
+    bool ready_ = false;
+    Arena table_[TableSize];
+    alignas(Alignment) uint8_t memory_[Capacity];
+};
+
+// std::pmr::memory_resource sobre un gestor; lanza std::bad_alloc si no hay memoria
+class MemoryResource : public std::pmr::memory_resource {
+public:
+    explicit MemoryResource(ArenaManager *manager) noexcept : manager_(manager) {}
+    template <std::size_t C, std::size_t T, std::size_t A, Engine E, bool S>
+    explicit MemoryResource(StaticManager<C, T, A, E, S> &manager) noexcept : manager_(manager.get()) {}
+
+    ArenaManager *manager() const noexcept { return manager_; }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void *ptr = detail::allocate(manager_, bytes, alignment);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+    void do_deallocate(void *ptr, std::size_t, std::size_t) override { sysarena_free(manager_, ptr); }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        const MemoryResource *o = dynamic_cast<const MemoryResource *>(&other);
+        return o && o->manager_ == manager_;
+    }
+
+    ArenaManager *manager_;
+};
+
+// Adaptador para contenedores estándar: std::vector<int, sysarena::Allocator<int>> v(alloc)
+template <class T>
+class Allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit Allocator(ArenaManager *manager) noexcept : manager_(manager) {}
+    template <std::size_t C, std::size_t N, std::size_t A, Engine E, bool S>
+    explicit Allocator(StaticManager<C, N, A, E, S> &manager) noexcept : manager_(manager.get()) {}
+    template <class U>
+    Allocator(const Allocator<U> &other) noexcept : manager_(other.manager()) {}
+
+    T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        void *ptr = detail::allocate(manager_, n * sizeof(T), alignof(T));
+        if (!ptr) throw std::bad_alloc();
+        return static_cast<T *>(ptr);
+    }
+    void deallocate(T *ptr, std::size_t) noexcept { sysarena_free(manager_, ptr); }
+
+    ArenaManager *manager() const noexcept { return manager_; }
+
+    template <class U>
+    bool operator==(const Allocator<U> &other) const noexcept { return manager_ == other.manager(); }
+    template <class U>
+    bool operator!=(const Allocator<U> &other) const noexcept { return manager_ != other.manager(); }
+
+private:
+    ArenaManager *manager_;
+};
+
+// Arena temporal con dueño: devuelve sus trozos al gestor al destruirse.
+// Si la inicialización falla, allocate y make devuelven nullptr y reset no hace nada
+class Scratch {
+public:
+    Scratch(ArenaManager *manager, std::size_t chunk_size) noexcept {
+        ready_ = sysarena_scratch_init(&scratch_, manager, chunk_size);
+    }
+    template <std::size_t C, std::size_t T, std::size_t A, Engine E, bool S>
+    Scratch(StaticManager<C, T, A, E, S> &manager, std::size_t chunk_size) noexcept : Scratch(manager.get(), chunk_size) {}
+    ~Scratch() {
+        if (ready_) sysarena_scratch_release(&scratch_);
+    }
+    Scratch(const Scratch &) = delete;
+    Scratch &operator=(const Scratch &) = delete;
+
+    explicit operator bool() const noexcept { return ready_; }
+    ArenaScratch *get() noexcept { return &scratch_; }
+
+    void *allocate(std::size_t size) noexcept { return ready_ ? sysarena_scratch_alloc(&scratch_, size) : nullptr; }
+    // Construye un T en la arena; nunca se destruye, así que debe ser trivialmente destructible
+    template <class T, class... Args>
+    T *make(Args &&...args) {
+        static_assert(std::is_trivially_destructible<T>::value, "sysarena: Scratch::make no llama a destructores");
+        static_assert(alignof(T) <= SYSARENA_ALIGNMENT, "sysarena: Scratch::make no admite esa alineación");
+        void *ptr = allocate(sizeof(T));
+        return ptr ? new (ptr) T(std::forward<Args>(args)...) : nullptr;
+    }
+    void reset() noexcept {
+        if (ready_) sysarena_scratch_reset(&scratch_);
+    }
+
+private:
+    ArenaScratch scratch_{};
+    bool ready_ = false;
+};
+
+// Ámbito de una arena temporal: al salir se vuelve al punto de control tomado al entrar
+class ScratchScope {
+public:
+    explicit ScratchScope(ArenaScratch *scratch) noexcept : scratch_(scratch), mark_(sysarena_scratch_mark(scratch)) {}
+    explicit ScratchScope(Scratch &scratch) noexcept : ScratchScope(scratch ? scratch.get() : nullptr) {}
+    ~ScratchScope() { sysarena_scratch_rewind(scratch_, mark_); }
+    ScratchScope(const ScratchScope &) = delete;
+    ScratchScope &operator=(const ScratchScope &) = delete;
+
+private:
+    ArenaScratch *scratch_;
+    ArenaScratchMark mark_;
+};
+
+} // namespace sysarena
+
+#endif
@@ -14,6 +14,23 @@
 
 #include "types.h"
 #include "sysarena.h"
+#include "sysarena_internal.h"
+
+// Busca un bloque libre de al menos size bytes sin recorrer la tabla
+static Arena *bin_find(ArenaManager *manager, size_t size) {
+    size_t idx = bin_index(size);
+    // Desde el cajón redondeado hacia arriba cualquier bloque sirve
+    size_t fit = idx + ((size & (size - 1)) != 0);
+    if (fit < SYSARENA_BINS) {
+        uint64_t map = manager->bin_map & (~(uint64_t)0 << fit);
+        if (map) return manager->bins[__builtin_ctzll(map)];
+    }
+    // Último recurso: el propio cajón puede tener un bloque suficiente
+    for (Arena *arena = manager->bins[idx]; arena; arena = arena->next_free) {
+        if (arena->size >= size) return arena;
+    }
+    return NULL;
+}
 
 void poor_arena_init(Arena *arena) {
     if (!arena) return;
@@ -22,6 +39,10 @@ void poor_arena_init(Arena *arena) {
     arena->base = NULL;
     arena->in_use = false;
     arena->is_contiguous = false;
+    arena->prev = NULL;
+    arena->next = NULL;
+    arena->prev_free = NULL;
+    arena->next_free = NULL;
 }
 
 bool arena_init(Arena *arena, size_t size, ptr_t base) {
@@ -34,102 +55,519 @@ bool arena_init(Arena *arena, size_t size, ptr_t base) {
     return true;
 }
 
+void* arena_alloc(Arena *arena, size_t size) {
+    if (!arena || !arena->base || size == 0) return NULL;
+    size_t offset = align_up((uintptr_t)arena->base + arena->used, SYSARENA_ALIGNMENT) - (uintptr_t)arena->base;
+    if (offset > arena->size || size > arena->size - offset) return NULL;
+    arena->used = offset + size;
+    return (uint8_t*)arena->base + offset;
+}
+
+void arena_free(Arena *arena) {
+    if (!arena) return;
+    arena->used = 0;
+}
+
 bool sysarena_init(ArenaManager *manager, uint8_t *memory, Arena *arenas, size_t total_size, size_t num_arenas) {
+    return sysarena_init_ex(manager, memory, arenas, total_size, num_arenas, 0);
+}
+
+bool sysarena_init_ex(ArenaManager *manager, uint8_t *memory, Arena *arenas, size_t total_size, size_t num_arenas, unsigned flags) {
     if (!manager || !memory || !arenas || num_arenas < 1) return false;
+    // Todo bloque empieza alineado a SYSARENA_ALIGNMENT: se descarta el pico inicial
+    size_t skew = align_up((uintptr_t)memory, SYSARENA_ALIGNMENT) - (uintptr_t)memory;
+    if (skew > total_size) return false;
+    memory += skew;
+    total_size = (total_size - skew) & ~(SYSARENA_ALIGNMENT - 1);
+
     manager->arenas = arenas;
     manager->max_arenas = num_arenas;
     manager->initial_memory = memory;
     manager->initial_size = total_size;
     manager->current_arena_idx = 0;
+    manager->flags = flags;
+    manager->lock = false;
+    manager->backend = NULL;
+    manager->committed = total_size;
+    manager->table_capacity = num_arenas;
+    manager->stats = (ArenaStats){ 0 };
+    manager->coalesce = SYSARENA_COALESCE_EAGER;
+    manager->coalesce_param = 0;
+    manager->pending_frees = 0;
+    manager->merge_cursor = &manager->arenas[0];
+    manager->caches = NULL;
+    manager->spare = NULL;
+    manager->bin_map = 0;
+    for (size_t i = 0; i < SYSARENA_BINS; i++) {
+        manager->bins[i] = NULL;
+    }
 
+    // arenas[0] es siempre el primer bloque físico; el resto queda de reserva
     poor_arena_init(&manager->arenas[0]);
-    arena_init(&manager->arenas[0], total_size, memory);
-    for (size_t i = 1; i < num_arenas; i++) {
-        poor_arena_init(&manager->arenas[i]);
+    for (size_t i = num_arenas - 1; i > 0; i--) {
+        spare_give(manager, &manager->arenas[i]);
     }
+    STAT_ADD(manager, live_entries, 1);
+    if (flags & SYSARENA_ENGINE_BUDDY) return sysarena_buddy_init(manager);
+
+    arena_init(&manager->arenas[0], total_size, memory);
+    manager->arenas[0].in_use = false;
+    bin_insert(manager, &manager->arenas[0]);
     return true;
 }
 
-void* sysarena_alloc(ArenaManager *manager, size_t size) {
-    if (!manager || size == 0) return NULL;
+// Absorbe en block (fuera de su cajón) todos los libres contiguos que le siguen, incluidas
+// las entradas vacías que abre sysarena_displacement
+static void merge_next(ArenaManager *manager, Arena *block) {
+    while (block->next && can_coalesce(block, block->next)) {
+        Arena *next = block->next;
+        bin_remove(manager, next);
+        absorb(manager, block, next);
+    }
+}
+
+// Deja en block los primeros size bytes; el resto pasa a un bloque libre nuevo
+static Arena *split_block(ArenaManager *manager, Arena *block, size_t size) {
+    bool was_free = !block->in_use;
+    Arena *remainder = link_after(manager, block);
+    if (!remainder) return NULL;
+    STAT_ADD(manager, splits, 1);
+    if (was_free) bin_remove(manager, block);
+    remainder->base = (uint8_t*)block->base + size;
+    remainder->size = block->size - size;
+    block->size = size;
+    if (was_free) bin_insert(manager, block);
+    merge_next(manager, remainder);
+    bin_insert(manager, remainder);
+    return remainder;
+}
 
-    size_t source_arena_idx = 0;
-    while (source_arena_idx < manager->max_arenas && (!manager->arenas[source_arena_idx].in_use || (manager->arenas[source_arena_idx].size - manager->arenas[source_arena_idx].used) < size)) {
-        source_arena_idx++;
+// Fusiona un bloque recién liberado solo con sus vecinos físicos y lo encola
+static Arena *coalesce(ArenaManager *manager, Arena *arena) {
+    merge_next(manager, arena);
+    // Hacia atrás se sigue mientras haya libres: una entrada vacía puede separar dos bloques
+    while (arena->prev && can_coalesce(arena->prev, arena)) {
+        Arena *prev = arena->prev;
+        bin_remove(manager, prev);
+        absorb(manager, prev, arena);
+        arena = prev;
     }
+    bin_insert(manager, arena);
+    return arena;
+}
+
+// Entrada a la que apunta la cabecera de ptr, ocupada o no, si ptr es de la región
+static Arena *header_owner(ArenaManager *manager, void *ptr) {
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t start = (uintptr_t)manager->initial_memory;
+    if (p < start + SYSARENA_HEADER || p >= start + manager->committed || p % SYSARENA_ALIGNMENT) return NULL;
+
+    ArenaHeader *header = (ArenaHeader*)(p - SYSARENA_HEADER);
+    Arena *arena = header->arena;
+    if (!is_entry(manager, arena)) return NULL;
+    // Con alineación explícita la cabecera puede ir dentro del bloque, no en su base
+    if ((uint8_t*)header < (uint8_t*)arena->base || (uint8_t*)header >= (uint8_t*)arena->base + arena->size) return NULL;
+    return arena;
+}
+
+// Devuelve la entrada dueña de ptr leyendo su cabecera, o NULL si no es nuestro
+Arena *sysarena_block_of(ArenaManager *manager, void *ptr) {
+    Arena *arena = header_owner(manager, ptr);
+    return arena && arena->in_use ? arena : NULL;
+}
 
-    if (source_arena_idx >= manager->max_arenas) {
+// Ocupa block (ya fuera de su cajón) y devuelve al cajón lo que sobre tras needed bytes
+static void *take_block(ArenaManager *manager, Arena *block, size_t needed, size_t size) {
+    block->used = size;
+    block->in_use = true;
+    // Si sobra espacio pero no queda hueco en la tabla, no se entrega el bloque entero
+    if (block->size - needed >= SYSARENA_MIN_BLOCK && !split_block(manager, block, needed)) {
+        block->in_use = false;
+        block->used = 0;
+        coalesce(manager, block);
+        STAT_ADD(manager, table_exhausted, 1);
+        STAT_ADD(manager, failed_allocs, 1);
         return NULL;
     }
+    STAT_ADD(manager, allocs, 1);
+    stat_in_use(manager, block->size);
+    ArenaHeader *header = block->base;
+    header->arena = block;
+    header->owner = NULL;
+    return (uint8_t*)block->base + SYSARENA_HEADER;
+}
+
+// Fusiona pares libres contiguos desde *cursor con como mucho budget pasos; al llegar
+// al final vuelve a la cabeza. Devuelve cuántas fusiones ha hecho
+static size_t merge_steps(ArenaManager *manager, Arena **cursor, size_t budget) {
+    Arena *a = *cursor;
+    size_t merged = 0;
+    for (; budget > 0 && a->next; budget--) {
+        Arena *b = a->next;
+        if (can_coalesce(a, b)) {
+            bin_remove(manager, a);
+            bin_remove(manager, b);
+            absorb(manager, a, b);
+            bin_insert(manager, a);
+            merged++;
+        } else {
+            a = b;
+        }
+    }
+    if (!a->next) {
+        if (!a->in_use && manager->backend) manager->backend->release(manager, a);
+        a = &manager->arenas[0];
+    }
+    *cursor = a;
+    return merged;
+}
+
+static size_t merge_all(ArenaManager *manager) {
+    Arena *head = &manager->arenas[0];
+    manager->pending_frees = 0;
+    return merge_steps(manager, &head, SIZE_MAX);
+}
 
-    Arena original_source_arena_data = manager->arenas[source_arena_idx];
+// Busca bloque; con fusión perezosa, si no hay, fusiona todo y lo vuelve a intentar
+static Arena *find_block(ArenaManager *manager, size_t size) {
+    Arena *block = bin_find(manager, size);
+    if (!block && manager->coalesce != SYSARENA_COALESCE_EAGER && merge_all(manager)) {
+        block = bin_find(manager, size);
+    }
+    return block;
+}
 
-    void* allocated_base_address = (uint8_t*)original_source_arena_data.base + original_source_arena_data.used;
+// Trabajo de fusión que toca tras frees bloques liberados sin fusionar
+static void lazy_coalesce(ArenaManager *manager, size_t frees) {
+    if (manager->coalesce == SYSARENA_COALESCE_INCREMENTAL) {
+        merge_steps(manager, &manager->merge_cursor, manager->coalesce_param);
+        return;
+    }
+    manager->pending_frees += frees;
+    if (manager->coalesce_param && manager->pending_frees >= manager->coalesce_param) merge_all(manager);
+}
+
+void* sysarena_alloc_unlocked(ArenaManager *manager, size_t size) {
+    if (size == 0) return NULL;
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) return sysarena_buddy_alloc(manager, size);
 
-    if ((original_source_arena_data.size - original_source_arena_data.used) > size) {
-        if (source_arena_idx + 1 >= manager->max_arenas) {
+    size_t needed = align_up(size + SYSARENA_HEADER, SYSARENA_ALIGNMENT);
+    if (needed < size) return NULL;
+    Arena *block = find_block(manager, needed);
+    if (!block || !sysarena_commit(manager, (uint8_t*)block->base + needed)) {
+        STAT_ADD(manager, failed_allocs, 1);
+        return NULL;
+    }
+    bin_remove(manager, block);
+    return take_block(manager, block, needed, size);
+}
+
+void* sysarena_alloc_aligned_unlocked(ArenaManager *manager, size_t size, size_t alignment) {
+    if (size == 0 || (alignment & (alignment - 1))) return NULL;
+    if (alignment <= SYSARENA_ALIGNMENT) return sysarena_alloc_unlocked(manager, size);
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) return sysarena_buddy_alloc_aligned(manager, size, alignment);
+
+    // El hueco delantero se queda libre como bloque propio, así que debe caber uno mínimo
+    size_t needed = align_up(size + SYSARENA_HEADER, SYSARENA_ALIGNMENT);
+    size_t worst = needed + alignment + SYSARENA_MIN_BLOCK;
+    if (needed < size || worst < needed) return NULL;
+    Arena *block = find_block(manager, worst);
+    if (!block) {
+        STAT_ADD(manager, failed_allocs, 1);
+        return NULL;
+    }
+
+    uintptr_t data = (uintptr_t)block->base + SYSARENA_HEADER;
+    size_t gap = align_up(data, alignment) - data;
+    if (gap > 0 && gap < SYSARENA_MIN_BLOCK) gap += alignment;
+    if (!sysarena_commit(manager, (uint8_t*)block->base + gap + needed)) {
+        STAT_ADD(manager, failed_allocs, 1);
+        return NULL;
+    }
+    if (gap > 0) {
+        block = split_block(manager, block, gap);
+        if (!block) {
+            STAT_ADD(manager, table_exhausted, 1);
+            STAT_ADD(manager, failed_allocs, 1);
             return NULL;
         }
+    }
+    bin_remove(manager, block);
+    return take_block(manager, block, needed, size);
+}
 
-        for (size_t i = manager->max_arenas - 1; i > source_arena_idx; --i) {
-            manager->arenas[i] = manager->arenas[i - 1];
-        }
+void* sysarena_alloc(ArenaManager *manager, size_t size) {
+    if (!manager) return NULL;
+    sysarena_lock(manager);
+    void *ptr = sysarena_alloc_unlocked(manager, size);
+    sysarena_unlock(manager);
+    return ptr;
+}
+
+void* sysarena_alloc_aligned(ArenaManager *manager, size_t size, size_t alignment) {
+    if (!manager) return NULL;
+    sysarena_lock(manager);
+    void *ptr = sysarena_alloc_aligned_unlocked(manager, size, alignment);
+    sysarena_unlock(manager);
+    return ptr;
+}
+
+void* sysarena_alloc_cacheline(ArenaManager *manager, size_t size) {
+    size_t padded = align_up(size, SYSARENA_CACHE_LINE);
+    if (padded < size) return NULL;
+    return sysarena_alloc_aligned(manager, padded, SYSARENA_CACHE_LINE);
+}
+
+bool sysarena_free_unlocked(ArenaManager *manager, void *ptr) {
+    Arena *arena = sysarena_block_of(manager, ptr);
+    if (!arena) return false;
+    STAT_ADD(manager, frees, 1);
+    STAT_SUB(manager, bytes_in_use, arena->size);
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) {
+        sysarena_buddy_free(manager, arena);
+        return true;
+    }
+    arena->in_use = false;
+    arena->used = 0;
+    if (manager->coalesce != SYSARENA_COALESCE_EAGER) {
+        bin_insert(manager, arena);
+        if (manager->backend) manager->backend->release(manager, arena);
+        lazy_coalesce(manager, 1);
+        return true;
+    }
+    arena = coalesce(manager, arena);
+    if (manager->backend) manager->backend->release(manager, arena);
+    return true;
+}
+
+// Intenta ajustar block a size bytes de datos sin moverlo
+static bool resize_in_place(ArenaManager *manager, Arena *block, uint8_t *ptr, size_t size) {
+    size_t offset = (size_t)(ptr - (uint8_t*)block->base);
+    size_t needed = align_up(offset + size, SYSARENA_ALIGNMENT);
+    if (needed < size) return false;
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) {
+        if (needed > block->size) return false;
+        block->used = size;
+        return true;
+    }
+    size_t old_block = block->size;
 
-        Arena *allocated_arena_ptr = &manager->arenas[source_arena_idx];
-        allocated_arena_ptr->base = allocated_base_address;
-        allocated_arena_ptr->size = size;
-        allocated_arena_ptr->used = size;
-        allocated_arena_ptr->in_use = true;
-        allocated_arena_ptr->is_contiguous = true;
+    if (needed > block->size) {
+        // Crecer absorbiendo el bloque físicamente siguiente si está libre
+        Arena *next = block->next;
+        if (!next || next->in_use || (uint8_t*)block->base + block->size != (uint8_t*)next->base ||
+            block->size + next->size < needed || !sysarena_commit(manager, (uint8_t*)block->base + needed)) return false;
+        bin_remove(manager, next);
+        absorb(manager, block, next);
+    }
+    // Encoger (o recortar lo absorbido de más) devolviendo la cola a su cajón
+    if (block->size - needed >= SYSARENA_MIN_BLOCK) {
+        Arena *tail = split_block(manager, block, needed);
+        if (tail && manager->backend) manager->backend->release(manager, tail);
+    }
+    if (block->size > old_block) stat_in_use(manager, block->size - old_block);
+    else STAT_SUB(manager, bytes_in_use, old_block - block->size);
+    block->used = size;
+    return true;
+}
+
+void* sysarena_realloc(ArenaManager *manager, void *ptr, size_t size) {
+    return sysarena_realloc_aligned(manager, ptr, size, SYSARENA_ALIGNMENT);
+}
+
+void* sysarena_realloc_aligned(ArenaManager *manager, void *ptr, size_t size, size_t alignment) {
+    if (!manager || (alignment & (alignment - 1))) return NULL;
+    if (!ptr) return sysarena_alloc_aligned(manager, size, alignment);
+    if (size == 0) {
+        sysarena_free(manager, ptr);
+        return NULL;
+    }
 
-        Arena *remainder_arena_ptr = &manager->arenas[source_arena_idx + 1];
-        remainder_arena_ptr->base = (uint8_t*)allocated_base_address + size;
-        remainder_arena_ptr->size = original_source_arena_data.size - original_source_arena_data.used - size;
-        remainder_arena_ptr->used = 0;
-        remainder_arena_ptr->in_use = (remainder_arena_ptr->size > 0);
-        remainder_arena_ptr->is_contiguous = true;
+    sysarena_lock(manager);
+    Arena *block = sysarena_block_of(manager, ptr);
+    if (!block) {
+        sysarena_unlock(manager);
+        return NULL;
+    }
+    ArenaThreadCache *owner = sysarena_header(ptr)->owner;
+    size_t old_size = block->used;
 
-        return allocated_arena_ptr->base;
+    // Los bloques de una caché conservan su clase: solo caben tamaños de esa clase
+    if (owner ? size <= old_size : resize_in_place(manager, block, ptr, size)) {
+        sysarena_unlock(manager);
+        return ptr;
+    }
 
-    } else {
-        manager->arenas[source_arena_idx].base = allocated_base_address;
-        manager->arenas[source_arena_idx].size = size;
-        manager->arenas[source_arena_idx].used = size;
-        manager->arenas[source_arena_idx].in_use = true;
-        return manager->arenas[source_arena_idx].base;
+    void *moved = sysarena_alloc_aligned_unlocked(manager, size, alignment);
+    if (moved) {
+        __builtin_memcpy(moved, ptr, old_size < size ? old_size : size);
+        if (owner) sysarena_cache_release_unlocked(manager, owner, ptr);
+        else sysarena_free_unlocked(manager, ptr);
     }
+    sysarena_unlock(manager);
+    return moved;
 }
 
 bool sysarena_free(ArenaManager *manager, void *ptr) {
     if (!manager || !ptr) return false;
-    for (size_t i = 0; i < manager->max_arenas; i++) {
-        Arena *arena = &manager->arenas[i];
-        if (arena->in_use && arena->base &&
-            (uint8_t*)ptr >= (uint8_t*)arena->base && (uint8_t*)ptr < (uint8_t*)arena->base + arena->size) {
-            poor_arena_init(arena);
-            sysarena_defragment(manager);
-            return true;
+    sysarena_lock(manager);
+    bool freed = sysarena_free_unlocked(manager, ptr);
+    sysarena_unlock(manager);
+    return freed;
+}
+
+// Ocupa los primeros bloques de needed bytes de block (ya fuera de su cajón) de una pasada
+static size_t carve_run(ArenaManager *manager, Arena *block, size_t needed, size_t size, size_t count, void **out) {
+    size_t got = 0;
+    for (;;) {
+        size_t rest = block->size - needed;
+        Arena *tail = NULL;
+        if (rest >= SYSARENA_MIN_BLOCK) {
+            tail = link_after(manager, block);
+            if (!tail) {
+                // Sin entrada para el resto, el bloque no se entrega entero: vuelve a su cajón
+                STAT_ADD(manager, table_exhausted, 1);
+                coalesce(manager, block);
+                return got;
+            }
+            STAT_ADD(manager, splits, 1);
+            tail->base = (uint8_t*)block->base + needed;
+            tail->size = rest;
+            block->size = needed;
+        }
+        block->used = size;
+        block->in_use = true;
+        ArenaHeader *header = block->base;
+        header->arena = block;
+        header->owner = NULL;
+        out[got++] = (uint8_t*)block->base + SYSARENA_HEADER;
+        STAT_ADD(manager, allocs, 1);
+        stat_in_use(manager, block->size);
+        if (!tail) return got;
+        if (got == count || rest < needed) {
+            // Lo que sobra vuelve a su cajón como un único bloque libre
+            merge_next(manager, tail);
+            bin_insert(manager, tail);
+            return got;
         }
+        block = tail;
     }
-    return false;
 }
 
-void sysarena_defragment(ArenaManager *manager) {
-    if (!manager) return;
-    for (size_t i = 0; i < manager->max_arenas - 1; i++) {
-        Arena *a = &manager->arenas[i];
-        Arena *b = &manager->arenas[i + 1];
-        if (!a->in_use && !b->in_use && a->size > 0 && b->size > 0 &&
-            (uint8_t*)a->base + a->size == (uint8_t*)b->base) {
-            a->size += b->size;
-            poor_arena_init(b);
-            for (size_t j = i + 1; j < manager->max_arenas - 1; j++) {
-                manager->arenas[j] = manager->arenas[j + 1];
-            }
-            poor_arena_init(&manager->arenas[manager->max_arenas - 1]);
-            i--;
+size_t sysarena_alloc_batch_unlocked(ArenaManager *manager, size_t size, size_t count, void **out) {
+    size_t got = 0;
+    if (size == 0) return 0;
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) {
+        // Cada bloque buddy tiene su orden: no hay región común que trocear
+        for (; got < count; got++) {
+            if (!(out[got] = sysarena_buddy_alloc(manager, size))) break;
         }
+        return got;
+    }
+
+    size_t needed = align_up(size + SYSARENA_HEADER, SYSARENA_ALIGNMENT);
+    if (needed < size) return 0;
+    while (got < count) {
+        // Primero una región donde quepa todo lo que falta; si no, la que haya
+        size_t left = count - got;
+        Arena *block = left <= SIZE_MAX / needed ? bin_find(manager, needed * left) : NULL;
+        if (!block) block = find_block(manager, needed);
+        if (!block) break;
+        size_t pieces = block->size / needed;
+        if (pieces > left) pieces = left;
+        if (!sysarena_commit(manager, (uint8_t*)block->base + pieces * needed)) break;
+        bin_remove(manager, block);
+        size_t carved = carve_run(manager, block, needed, size, pieces, out + got);
+        got += carved;
+        if (carved < pieces) break;
+    }
+    if (got < count) STAT_ADD(manager, failed_allocs, 1);
+    return got;
+}
+
+size_t sysarena_alloc_batch(ArenaManager *manager, size_t size, size_t count, void **out) {
+    if (!manager || !out) return 0;
+    sysarena_lock(manager);
+    size_t got = sysarena_alloc_batch_unlocked(manager, size, count, out);
+    sysarena_unlock(manager);
+    return got;
+}
+
+// Fusiona de una vez toda la racha de bloques libres (ya en sus cajones) que contiene arena
+static Arena *coalesce_run(ArenaManager *manager, Arena *arena) {
+    while (arena->prev && can_coalesce(arena->prev, arena)) arena = arena->prev;
+    bin_remove(manager, arena);
+    while (arena->next && can_coalesce(arena, arena->next)) {
+        bin_remove(manager, arena->next);
+        absorb(manager, arena, arena->next);
     }
+    bin_insert(manager, arena);
+    return arena;
+}
+
+size_t sysarena_free_batch_unlocked(ArenaManager *manager, void **ptrs, size_t count) {
+    size_t freed = 0;
+    // Primera pasada: marcar libres sin fusionar (las cabeceras siguen intactas)
+    for (size_t i = 0; i < count; i++) {
+        Arena *arena = sysarena_block_of(manager, ptrs[i]);
+        if (!arena) continue;
+        STAT_ADD(manager, frees, 1);
+        STAT_SUB(manager, bytes_in_use, arena->size);
+        freed++;
+        if (manager->flags & SYSARENA_ENGINE_BUDDY) {
+            sysarena_buddy_free(manager, arena);
+            continue;
+        }
+        arena->in_use = false;
+        arena->used = 0;
+        bin_insert(manager, arena);
+    }
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) return freed;
+    if (manager->coalesce != SYSARENA_COALESCE_EAGER) {
+        if (freed) lazy_coalesce(manager, freed);
+        return freed;
+    }
+
+    // Segunda pasada: una fusión por racha; las entradas ya absorbidas están en la reserva
+    for (size_t i = 0; i < count; i++) {
+        Arena *arena = header_owner(manager, ptrs[i]);
+        if (!arena || arena->in_use) continue;
+        arena = coalesce_run(manager, arena);
+        if (manager->backend) manager->backend->release(manager, arena);
+    }
+    return freed;
+}
+
+size_t sysarena_free_batch(ArenaManager *manager, void **ptrs, size_t count) {
+    if (!manager || !ptrs) return 0;
+    sysarena_lock(manager);
+    size_t freed = sysarena_free_batch_unlocked(manager, ptrs, count);
+    sysarena_unlock(manager);
+    return freed;
+}
+
+void sysarena_defragment(ArenaManager *manager) {
+    // El motor buddy ya fusiona todo lo posible al liberar
+    if (!manager || (manager->flags & SYSARENA_ENGINE_BUDDY)) return;
+    sysarena_lock(manager);
+    // Recorre la cadena física: fusionar es actualizar punteros, no desplazar la tabla
+    merge_all(manager);
+    sysarena_unlock(manager);
+}
+
+bool sysarena_set_coalesce(ArenaManager *manager, unsigned mode, size_t param) {
+    if (!manager || mode > SYSARENA_COALESCE_INCREMENTAL) return false;
+    if (mode == SYSARENA_COALESCE_INCREMENTAL && param == 0) return false;
+    if ((manager->flags & SYSARENA_ENGINE_BUDDY) && mode != SYSARENA_COALESCE_EAGER) return false;
+    sysarena_lock(manager);
+    // La fusión inmediata supone que ningún bloque libre tiene un vecino libre
+    if (mode == SYSARENA_COALESCE_EAGER && manager->coalesce != SYSARENA_COALESCE_EAGER) merge_all(manager);
+    manager->coalesce = mode;
+    manager->coalesce_param = param;
+    manager->pending_frees = 0;
+    manager->merge_cursor = &manager->arenas[0];
+    sysarena_unlock(manager);
+    return true;
 }
 
 bool arena_can_merge(const Arena *a, const Arena *b) {
@@ -153,17 +591,36 @@ void copy_arena(Arena *dest, const Arena *src) {
     dest->is_contiguous = src->is_contiguous;
 }
 void sysarena_displacement(ArenaManager *manager, size_t where) {
+    if (!manager || where >= manager->max_arenas || (manager->flags & SYSARENA_ENGINE_BUDDY)) return;
+    Arena *arena = &manager->arenas[where];
+    sysarena_lock(manager);
+    if (arena->base) link_after(manager, arena);
+    sysarena_unlock(manager);
 }
 bool sysarena_split(ArenaManager *manager, size_t index, size_t size) {
-    return false;
+    if (!manager || index >= manager->max_arenas || (manager->flags & SYSARENA_ENGINE_BUDDY)) return false;
+    Arena *arena = &manager->arenas[index];
+    size = align_up(size, SYSARENA_ALIGNMENT);
+    sysarena_lock(manager);
+    size_t old_size = arena->size;
+    bool split = arena->base && size > 0 && size < arena->size &&
+                 (!arena->in_use || size >= align_up(arena->used + SYSARENA_HEADER, SYSARENA_ALIGNMENT)) &&
+                 split_block(manager, arena, size) != NULL;
+    // La cola de un bloque ocupado deja de contar como memoria en uso
+    if (split && arena->in_use) STAT_SUB(manager, bytes_in_use, old_size - arena->size);
+    sysarena_unlock(manager);
+    return split;
 }
 bool sysarena_is_fully_merged(ArenaManager *manager) {
     if (!manager) return false;
-    size_t active_arenas = 0;
-    for (size_t i = 0; i < manager->max_arenas; i++) {
-        if (manager->arenas[i].in_use) active_arenas++;
+    if (manager->flags & SYSARENA_ENGINE_BUDDY) {
+        // Sin bloques ocupados, cada bloque ya está en su mayor orden posible
+        for (Arena *a = &manager->arenas[0]; a; a = a->next) {
+            if (a->in_use) return false;
+        }
+        return true;
     }
-    return active_arenas == 1 &&
+    return !manager->arenas[0].in_use && !manager->arenas[0].next &&
            manager->arenas[0].size == manager->initial_size &&
            manager->arenas[0].base == manager->initial_memory;
 }
@@ -0,0 +1,147 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+// Motor buddy: bloques de 2^k bytes alineados a 2^k respecto a initial_memory.
+// Las listas por orden son los mismos cajones del gestor (floor(log2(2^k)) = k)
+// y cada bloque, libre u ocupado, lleva su cabecera para encontrar a su buddy.
+
+static inline size_t min_order(void) {
+    return bin_index(SYSARENA_MIN_BLOCK);
+}
+
+static inline void buddy_mark(Arena *arena) {
+    ArenaHeader *header = arena->base;
+    header->arena = arena;
+    header->owner = NULL;
+}
+
+bool sysarena_buddy_init(ArenaManager *manager) {
+    size_t offset = 0;
+    size_t remaining = manager->initial_size;
+    Arena *last = NULL;
+
+    // Trocea la región en los mayores bloques alineados que quepan
+    while (remaining >= SYSARENA_MIN_BLOCK) {
+        size_t order = bin_index(remaining);
+        if (offset) {
+            size_t align = (size_t)__builtin_ctzll((uint64_t)offset);
+            if (align < order) order = align;
+        }
+        Arena *block = last ? link_after(manager, last) : &manager->arenas[0];
+        if (!block) break;
+        block->base = manager->initial_memory + offset;
+        block->size = (size_t)1 << order;
+        block->used = 0;
+        block->in_use = false;
+        block->is_contiguous = true;
+        buddy_mark(block);
+        bin_insert(manager, block);
+        offset += block->size;
+        remaining -= block->size;
+        last = block;
+    }
+    // Lo que no se ha podido trocear queda fuera de la región gestionada
+    manager->initial_size = offset;
+    manager->committed = offset;
+    return last != NULL;
+}
+
+void* sysarena_buddy_alloc(ArenaManager *manager, size_t size) {
+    size_t needed = size + SYSARENA_HEADER;
+    if (needed < size) return NULL;
+    size_t order = bin_index(needed) + ((needed & (needed - 1)) != 0);
+    if (order < min_order()) order = min_order();
+    if (order >= SYSARENA_BINS) return NULL;
+
+    uint64_t map = manager->bin_map & (~(uint64_t)0 << order);
+    if (!map) {
+        STAT_ADD(manager, failed_allocs, 1);
+        return NULL;
+    }
+    size_t k = (size_t)__builtin_ctzll(map);
+    Arena *block = manager->bins[k];
+    bin_remove(manager, block);
+
+    // Parte por la mitad hasta el orden pedido; la mitad alta es el buddy libre
+    while (k > order) {
+        Arena *buddy = link_after(manager, block);
+        if (!buddy) {
+            // Sin entradas no se entrega un bloque de orden mayor: se deshacen las mitades
+            sysarena_buddy_free(manager, block);
+            STAT_ADD(manager, table_exhausted, 1);
+            STAT_ADD(manager, failed_allocs, 1);
+            return NULL;
+        }
+        STAT_ADD(manager, splits, 1);
+        k--;
+        block->size = (size_t)1 << k;
+        buddy->base = (uint8_t*)block->base + block->size;
+        buddy->size = block->size;
+        buddy_mark(buddy);
+        bin_insert(manager, buddy);
+    }
+
+    block->used = size;
+    block->in_use = true;
+    buddy_mark(block);
+    STAT_ADD(manager, allocs, 1);
+    stat_in_use(manager, block->size);
+    return (uint8_t*)block->base + SYSARENA_HEADER;
+}
+
+void* sysarena_buddy_alloc_aligned(ArenaManager *manager, size_t size, size_t alignment) {
+    // Los bloques solo están alineados respecto a initial_memory: se rellena por dentro
+    size_t padded = size + alignment - SYSARENA_ALIGNMENT;
+    if (padded < size) return NULL;
+    uint8_t *ptr = sysarena_buddy_alloc(manager, padded);
+    if (!ptr) return NULL;
+    sysarena_header(ptr)->arena->used = size;
+
+    uint8_t *aligned = (uint8_t*)align_up((uintptr_t)ptr, alignment);
+    if (aligned != ptr) {
+        ArenaHeader *header = sysarena_header(ptr);
+        *sysarena_header(aligned) = *header;
+    }
+    return aligned;
+}
+
+void sysarena_buddy_free(ArenaManager *manager, Arena *block) {
+    block->in_use = false;
+    block->used = 0;
+
+    // Sube de orden mientras el buddy (offset ^ tamaño) esté libre y entero
+    for (;;) {
+        size_t offset = (uint8_t*)block->base - manager->initial_memory;
+        size_t buddy_offset = offset ^ block->size;
+        if (buddy_offset + block->size > manager->initial_size) break;
+
+        Arena *buddy = ((ArenaHeader*)(manager->initial_memory + buddy_offset))->arena;
+        if (!is_entry(manager, buddy) || buddy->base != manager->initial_memory + buddy_offset ||
+            buddy->in_use || buddy->size != block->size) break;
+
+        bin_remove(manager, buddy);
+        if (buddy_offset < offset) {
+            absorb(manager, buddy, block);
+            block = buddy;
+        } else {
+            absorb(manager, block, buddy);
+        }
+    }
+    buddy_mark(block);
+    bin_insert(manager, block);
+}
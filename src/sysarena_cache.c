@@ -0,0 +1,175 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+// Clase de caché de size: ceil(log2(size)) - 4, o SYSARENA_CACHE_CLASSES si no cabe en ninguna
+static inline size_t cache_class(size_t size) {
+    if (size <= 16) return 0;
+    size_t k = 64 - (size_t)__builtin_clzll((uint64_t)(size - 1)) - 4;
+    return k < SYSARENA_CACHE_CLASSES ? k : SYSARENA_CACHE_CLASSES;
+}
+
+static inline void cache_push(ArenaThreadCache *cache, size_t k, void *ptr) {
+    *(void**)ptr = cache->free_lists[k];
+    cache->free_lists[k] = ptr;
+    cache->counts[k]++;
+}
+
+static inline void *cache_pop(ArenaThreadCache *cache, size_t k) {
+    void *ptr = cache->free_lists[k];
+    if (ptr) {
+        cache->free_lists[k] = *(void**)ptr;
+        cache->counts[k]--;
+    }
+    return ptr;
+}
+
+// Recoge de una vez todo lo que otros hilos han liberado en nuestra cola
+static void drain_remote(ArenaThreadCache *cache) {
+    if (!__atomic_load_n(&cache->remote, __ATOMIC_RELAXED)) return;
+    void *ptr = __atomic_exchange_n(&cache->remote, NULL, __ATOMIC_ACQUIRE);
+    while (ptr) {
+        void *next = *(void**)ptr;
+        cache_push(cache, cache_class(sysarena_header(ptr)->arena->used), ptr);
+        ptr = next;
+    }
+}
+
+// Pide un lote de bloques de la clase k al gestor con una sola toma del cerrojo
+static bool refill(ArenaThreadCache *cache, size_t k) {
+    ArenaManager *manager = cache->manager;
+    void *batch[SYSARENA_CACHE_BATCH];
+    sysarena_lock(manager);
+    size_t got = sysarena_alloc_batch_unlocked(manager, (size_t)16 << k, SYSARENA_CACHE_BATCH, batch);
+    for (size_t i = 0; i < got; i++) {
+        sysarena_header(batch[i])->owner = cache;
+    }
+    sysarena_unlock(manager);
+    // Se apilan al revés para servir primero las direcciones más bajas
+    for (size_t i = got; i > 0; i--) {
+        cache_push(cache, k, batch[i - 1]);
+    }
+    return got > 0;
+}
+
+// Devuelve hasta count bloques de la clase k al gestor, una toma del cerrojo por lote
+static void flush(ArenaThreadCache *cache, size_t k, size_t count) {
+    ArenaManager *manager = cache->manager;
+    void *batch[SYSARENA_CACHE_BATCH];
+    while (count > 0 && cache->free_lists[k]) {
+        size_t n = 0;
+        for (; n < SYSARENA_CACHE_BATCH && count > 0 && cache->free_lists[k]; n++, count--) {
+            batch[n] = cache_pop(cache, k);
+        }
+        sysarena_lock(manager);
+        sysarena_free_batch_unlocked(manager, batch, n);
+        sysarena_unlock(manager);
+    }
+}
+
+// ¿Sigue viva cache? Se consulta con el cerrojo tomado
+static bool cache_alive(const ArenaManager *manager, const ArenaThreadCache *cache) {
+    for (const ArenaThreadCache *c = manager->caches; c; c = c->next) {
+        if (c == cache) return true;
+    }
+    return false;
+}
+
+void sysarena_cache_release_unlocked(ArenaManager *manager, ArenaThreadCache *owner, void *ptr) {
+    if (!cache_alive(manager, owner)) {
+        // Su caché ya no existe: el bloque vuelve directamente al gestor
+        sysarena_header(ptr)->owner = NULL;
+        sysarena_free_unlocked(manager, ptr);
+        return;
+    }
+    // Empuje MPSC: varios productores con CAS, el dueño lo vacía entero con un intercambio
+    void *head = __atomic_load_n(&owner->remote, __ATOMIC_RELAXED);
+    do {
+        *(void**)ptr = head;
+    } while (!__atomic_compare_exchange_n(&owner->remote, &head, ptr, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void sysarena_cache_init(ArenaThreadCache *cache, ArenaManager *manager) {
+    if (!cache) return;
+    cache->manager = manager;
+    for (size_t k = 0; k < SYSARENA_CACHE_CLASSES; k++) {
+        cache->free_lists[k] = NULL;
+        cache->counts[k] = 0;
+    }
+    cache->remote = NULL;
+    cache->next = NULL;
+    if (!manager) return;
+    sysarena_lock(manager);
+    cache->next = manager->caches;
+    manager->caches = cache;
+    sysarena_unlock(manager);
+}
+
+void* sysarena_cache_alloc(ArenaThreadCache *cache, size_t size) {
+    if (!cache || !cache->manager || size == 0) return NULL;
+    size_t k = cache_class(size);
+    if (k == SYSARENA_CACHE_CLASSES) return sysarena_alloc(cache->manager, size);
+
+    if (!cache->free_lists[k]) {
+        drain_remote(cache);
+        if (!cache->free_lists[k] && !refill(cache, k)) return NULL;
+    }
+    return cache_pop(cache, k);
+}
+
+bool sysarena_cache_free(ArenaThreadCache *cache, void *ptr) {
+    if (!cache || !cache->manager || !ptr) return false;
+
+    // Camino rápido: un bloque propio solo lo toca este hilo, su cabecera es estable
+    if (sysarena_header(ptr)->owner == cache) {
+        size_t k = cache_class(sysarena_header(ptr)->arena->used);
+        cache_push(cache, k, ptr);
+        if (cache->counts[k] > SYSARENA_CACHE_DEPTH) flush(cache, k, SYSARENA_CACHE_BATCH);
+        return true;
+    }
+
+    // Camino lento: validar y elegir destino con el cerrojo, que protege también la lista de cachés
+    ArenaManager *manager = cache->manager;
+    sysarena_lock(manager);
+    bool freed = sysarena_block_of(manager, ptr) != NULL;
+    if (freed) {
+        ArenaThreadCache *owner = sysarena_header(ptr)->owner;
+        if (owner) sysarena_cache_release_unlocked(manager, owner, ptr);
+        else sysarena_free_unlocked(manager, ptr);
+    }
+    sysarena_unlock(manager);
+    return freed;
+}
+
+void sysarena_cache_destroy(ArenaThreadCache *cache) {
+    if (!cache || !cache->manager) return;
+    ArenaManager *manager = cache->manager;
+    // Fuera de la lista, nadie más empuja en remote: lo que haya se recoge abajo
+    sysarena_lock(manager);
+    for (ArenaThreadCache **link = &manager->caches; *link; link = &(*link)->next) {
+        if (*link == cache) {
+            *link = cache->next;
+            break;
+        }
+    }
+    sysarena_unlock(manager);
+    drain_remote(cache);
+    for (size_t k = 0; k < SYSARENA_CACHE_CLASSES; k++) {
+        flush(cache, k, cache->counts[k]);
+    }
+    cache->manager = NULL;
+}
@@ -0,0 +1,209 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#ifndef _SYSARENA_INTERNAL_H
+#define _SYSARENA_INTERNAL_H
+
+#include "types.h"
+#include "sysarena.h"
+
+// Cabecera en banda delante de cada bloque: permite liberar sin buscar en la tabla
+typedef struct ArenaHeader {
+    Arena *arena;  // Entrada de la tabla dueña del bloque
+    void *owner;   // Caché de hilo dueña del bloque (NULL si es del gestor)
+} ArenaHeader;
+
+// La cabecera ocupa un múltiplo de SYSARENA_ALIGNMENT para que el bloque quede alineado
+#define SYSARENA_HEADER ((sizeof(ArenaHeader) + SYSARENA_ALIGNMENT - 1) & ~(SYSARENA_ALIGNMENT - 1))
+#define SYSARENA_MIN_BLOCK (2 * SYSARENA_HEADER)
+// Pausas máximas por vuelta de espera del cerrojo antes de ceder la CPU
+#define SYSARENA_SPIN_LIMIT 64
+
+static inline size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static inline ArenaHeader *sysarena_header(void *ptr) {
+    return (ArenaHeader*)((uint8_t*)ptr - SYSARENA_HEADER);
+}
+
+// Contadores: solo escribe quien tiene el gestor (cerrojo o un solo hilo), así que
+// basta un almacenamiento relajado sin instrucción atómica de lectura-modificación
+#ifdef SYSARENA_STATS
+#define STAT_ADD(manager, field, n) \
+    __atomic_store_n(&(manager)->stats.field, (manager)->stats.field + (n), __ATOMIC_RELAXED)
+#define STAT_SUB(manager, field, n) \
+    __atomic_store_n(&(manager)->stats.field, (manager)->stats.field - (n), __ATOMIC_RELAXED)
+#else
+#define STAT_ADD(manager, field, n) ((void)(n))
+#define STAT_SUB(manager, field, n) ((void)(n))
+#endif
+
+static inline void stat_in_use(ArenaManager *manager, size_t bytes) {
+    (void)manager;
+    (void)bytes;
+#ifdef SYSARENA_STATS
+    STAT_ADD(manager, bytes_in_use, bytes);
+    if (manager->stats.bytes_in_use > manager->stats.peak_bytes) {
+        __atomic_store_n(&manager->stats.peak_bytes, manager->stats.bytes_in_use, __ATOMIC_RELAXED);
+    }
+#endif
+}
+
+// Índice del cajón de un tamaño: floor(log2(size))
+static inline size_t bin_index(size_t size) {
+    return 63 - (size_t)__builtin_clzll((uint64_t)size);
+}
+
+static inline void bin_insert(ArenaManager *manager, Arena *arena) {
+    if (arena->size == 0) return;
+    size_t idx = bin_index(arena->size);
+    arena->prev_free = NULL;
+    arena->next_free = manager->bins[idx];
+    if (manager->bins[idx]) manager->bins[idx]->prev_free = arena;
+    manager->bins[idx] = arena;
+    manager->bin_map |= (uint64_t)1 << idx;
+}
+
+static inline void bin_remove(ArenaManager *manager, Arena *arena) {
+    if (arena->size == 0) return;
+    size_t idx = bin_index(arena->size);
+    if (arena->prev_free) arena->prev_free->next_free = arena->next_free;
+    else manager->bins[idx] = arena->next_free;
+    if (arena->next_free) arena->next_free->prev_free = arena->prev_free;
+    if (!manager->bins[idx]) manager->bin_map &= ~((uint64_t)1 << idx);
+    arena->prev_free = NULL;
+    arena->next_free = NULL;
+}
+
+static inline Arena *spare_take(ArenaManager *manager) {
+    if (!manager->spare && manager->backend) manager->backend->grow_table(manager);
+    Arena *arena = manager->spare;
+    if (arena) {
+        manager->spare = arena->next;
+        arena->next = NULL;
+    }
+    return arena;
+}
+
+static inline void spare_give(ArenaManager *manager, Arena *arena) {
+    poor_arena_init(arena);
+    arena->next = manager->spare;
+    manager->spare = arena;
+}
+
+// ¿Apunta arena a una entrada de la tabla del gestor?
+static inline bool is_entry(const ArenaManager *manager, const Arena *arena) {
+    uintptr_t a = (uintptr_t)arena;
+    uintptr_t table = (uintptr_t)manager->arenas;
+    return a >= table && a < table + manager->max_arenas * sizeof(Arena) && (a - table) % sizeof(Arena) == 0;
+}
+
+// Engancha un hueco de reserva justo detrás de block en la cadena física: O(1)
+static inline Arena *link_after(ArenaManager *manager, Arena *block) {
+    Arena *hole = spare_take(manager);
+    if (!hole) return NULL;
+    hole->base = (uint8_t*)block->base + block->size;
+    hole->is_contiguous = true;
+    hole->prev = block;
+    hole->next = block->next;
+    if (block->next) block->next->prev = hole;
+    block->next = hole;
+    STAT_ADD(manager, live_entries, 1);
+    return hole;
+}
+
+// b pasa a formar parte de a (ambos libres y fuera de sus cajones)
+static inline void absorb(ArenaManager *manager, Arena *a, Arena *b) {
+    a->size += b->size;
+    a->next = b->next;
+    if (b->next) b->next->prev = a;
+    // El cursor incremental nunca se queda en una entrada que vuelve a la reserva
+    if (manager->merge_cursor == b) manager->merge_cursor = a;
+    spare_give(manager, b);
+    STAT_ADD(manager, merges, 1);
+    STAT_SUB(manager, live_entries, 1);
+}
+
+static inline bool can_coalesce(const Arena *a, const Arena *b) {
+    return !a->in_use && !b->in_use && (uint8_t*)a->base + a->size == (uint8_t*)b->base;
+}
+
+// Asegura que la memoria hasta end es accesible (solo cambia algo con respaldo virtual)
+static inline bool sysarena_commit(ArenaManager *manager, uint8_t *end) {
+    return !manager->backend || manager->backend->commit(manager, end);
+}
+
+// Pausa dentro de la espera activa: libera recursos del núcleo para el otro hilo hermano
+static inline void sysarena_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Cerrojo de espera activa; solo se toma en modo SYSARENA_THREAD_SAFE.
+// Espera con pausas que se duplican hasta SYSARENA_SPIN_LIMIT; a partir de ahí cede la CPU
+// si el respaldo sabe hacerlo (sin sistema operativo se sigue girando)
+static inline void sysarena_lock(ArenaManager *manager) {
+    if (!(manager->flags & SYSARENA_THREAD_SAFE)) return;
+    unsigned backoff = 1;
+    while (__atomic_test_and_set(&manager->lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&manager->lock, __ATOMIC_RELAXED)) {
+            for (unsigned i = 0; i < backoff; i++) sysarena_cpu_relax();
+            if (backoff < SYSARENA_SPIN_LIMIT) {
+                backoff <<= 1;
+            } else if (manager->backend && manager->backend->yield) {
+                manager->backend->yield();
+            }
+        }
+    }
+}
+
+static inline void sysarena_unlock(ArenaManager *manager) {
+    if (!(manager->flags & SYSARENA_THREAD_SAFE)) return;
+    __atomic_clear(&manager->lock, __ATOMIC_RELEASE);
+}
+
+// Mayor bloque libre: basta mirar el cajón más alto con algo
+static inline size_t largest_free(const ArenaManager *manager) {
+    if (!manager->bin_map) return 0;
+    size_t largest = 0;
+    for (Arena *a = manager->bins[63 - __builtin_clzll(manager->bin_map)]; a; a = a->next_free) {
+        if (a->size > largest) largest = a->size;
+    }
+    return largest;
+}
+
+// Versiones sin cerrojo de la API pública (el llamante ya lo tiene)
+void* sysarena_alloc_unlocked(ArenaManager *manager, size_t size);
+void* sysarena_alloc_aligned_unlocked(ArenaManager *manager, size_t size, size_t alignment);
+bool sysarena_free_unlocked(ArenaManager *manager, void *ptr);
+size_t sysarena_alloc_batch_unlocked(ArenaManager *manager, size_t size, size_t count, void **out);
+size_t sysarena_free_batch_unlocked(ArenaManager *manager, void **ptrs, size_t count);
+
+// Devuelve un bloque a la caché dueña desde cualquier hilo (cola MPSC)
+void sysarena_cache_release_unlocked(ArenaManager *manager, ArenaThreadCache *owner, void *ptr);
+
+// Motor buddy (SYSARENA_ENGINE_BUDDY)
+bool sysarena_buddy_init(ArenaManager *manager);
+void* sysarena_buddy_alloc(ArenaManager *manager, size_t size);
+void* sysarena_buddy_alloc_aligned(ArenaManager *manager, size_t size, size_t alignment);
+void sysarena_buddy_free(ArenaManager *manager, Arena *block);
+
+// Entrada de la tabla dueña de ptr, o NULL si ptr no es un bloque vivo del gestor
+Arena *sysarena_block_of(ArenaManager *manager, void *ptr);
+
+#endif
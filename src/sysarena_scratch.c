@@ -0,0 +1,114 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+// Cada trozo guarda su estado de bump en un Arena y va seguido de sus datos
+typedef struct ArenaScratchChunk {
+    Arena arena;
+    struct ArenaScratchChunk *next;
+} ArenaScratchChunk;
+
+#define SCRATCH_CHUNK_HEADER align_up(sizeof(ArenaScratchChunk), SYSARENA_ALIGNMENT)
+
+// Engancha un trozo nuevo de al menos size bytes detrás del actual
+static ArenaScratchChunk *scratch_grow(ArenaScratch *scratch, size_t size) {
+    size_t capacity = size > scratch->chunk_size ? size : scratch->chunk_size;
+    if (capacity > (size_t)-1 - SCRATCH_CHUNK_HEADER) return NULL;
+    uint8_t *memory = sysarena_alloc(scratch->manager, SCRATCH_CHUNK_HEADER + capacity);
+    if (!memory) return NULL;
+
+    ArenaScratchChunk *chunk = (ArenaScratchChunk*)memory;
+    poor_arena_init(&chunk->arena);
+    arena_init(&chunk->arena, capacity, memory + SCRATCH_CHUNK_HEADER);
+    if (scratch->current) {
+        chunk->next = scratch->current->next;
+        scratch->current->next = chunk;
+    } else {
+        chunk->next = NULL;
+        scratch->first = chunk;
+    }
+    return chunk;
+}
+
+bool sysarena_scratch_init(ArenaScratch *scratch, ArenaManager *manager, size_t chunk_size) {
+    if (!scratch || !manager || chunk_size == 0) return false;
+    scratch->manager = manager;
+    scratch->chunk_size = chunk_size;
+    scratch->first = NULL;
+    scratch->current = NULL;
+    return true;
+}
+
+void* sysarena_scratch_alloc(ArenaScratch *scratch, size_t size) {
+    if (!scratch || size == 0) return NULL;
+    size = align_up(size, SYSARENA_ALIGNMENT);
+    if (size == 0) return NULL;
+
+    for (;;) {
+        if (scratch->current) {
+            void *ptr = arena_alloc(&scratch->current->arena, size);
+            if (ptr) return ptr;
+            // Tras un reset o rewind, los trozos siguientes están vacíos y se reutilizan
+            ArenaScratchChunk *next = scratch->current->next;
+            if (next && next->arena.size >= size) {
+                arena_free(&next->arena);
+                scratch->current = next;
+                continue;
+            }
+        }
+        ArenaScratchChunk *chunk = scratch_grow(scratch, size);
+        if (!chunk) return NULL;
+        scratch->current = chunk;
+    }
+}
+
+ArenaScratchMark sysarena_scratch_mark(const ArenaScratch *scratch) {
+    ArenaScratchMark mark = { NULL, 0 };
+    if (scratch && scratch->current) {
+        mark.chunk = scratch->current;
+        mark.used = scratch->current->arena.used;
+    }
+    return mark;
+}
+
+void sysarena_scratch_rewind(ArenaScratch *scratch, ArenaScratchMark mark) {
+    if (!scratch) return;
+    if (!mark.chunk) {
+        sysarena_scratch_reset(scratch);
+        return;
+    }
+    scratch->current = mark.chunk;
+    scratch->current->arena.used = mark.used;
+}
+
+void sysarena_scratch_reset(ArenaScratch *scratch) {
+    if (!scratch) return;
+    scratch->current = scratch->first;
+    if (scratch->current) arena_free(&scratch->current->arena);
+}
+
+void sysarena_scratch_release(ArenaScratch *scratch) {
+    if (!scratch) return;
+    ArenaScratchChunk *chunk = scratch->first;
+    while (chunk) {
+        ArenaScratchChunk *next = chunk->next;
+        sysarena_free(scratch->manager, chunk);
+        chunk = next;
+    }
+    scratch->first = NULL;
+    scratch->current = NULL;
+}
@@ -0,0 +1,77 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+// Cabecera de cada trozo; los objetos empiezan justo detrás
+#define SLAB_CHUNK_HEADER align_up(sizeof(void*), SYSARENA_ALIGNMENT)
+
+// Pide un trozo nuevo al gestor y encadena todos sus objetos en la lista libre
+static bool slab_grow(ArenaSlab *slab) {
+    uint8_t *chunk = sysarena_alloc(slab->manager, SLAB_CHUNK_HEADER + slab->object_size * slab->objects_per_chunk);
+    if (!chunk) return false;
+    *(void**)chunk = slab->chunks;
+    slab->chunks = chunk;
+
+    uint8_t *object = chunk + SLAB_CHUNK_HEADER;
+    for (size_t i = slab->objects_per_chunk; i > 0; i--) {
+        *(void**)object = slab->free_list;
+        slab->free_list = object;
+        object += slab->object_size;
+    }
+    return true;
+}
+
+bool sysarena_slab_create(ArenaSlab *slab, ArenaManager *manager, size_t object_size, size_t objects_per_chunk) {
+    if (!slab || !manager || object_size == 0 || objects_per_chunk == 0) return false;
+    // Cada objeto queda alineado como cualquier bloque del gestor
+    size_t stride = align_up(object_size, SYSARENA_ALIGNMENT);
+    if (stride < object_size) return false;
+    // El trozo entero (cabecera + objetos) debe caber en un size_t
+    if (objects_per_chunk > (SIZE_MAX - SLAB_CHUNK_HEADER) / stride) return false;
+    slab->manager = manager;
+    slab->object_size = stride;
+    slab->objects_per_chunk = objects_per_chunk;
+    slab->free_list = NULL;
+    slab->chunks = NULL;
+    return true;
+}
+
+void* sysarena_slab_alloc(ArenaSlab *slab) {
+    if (!slab) return NULL;
+    if (!slab->free_list && !slab_grow(slab)) return NULL;
+    void *object = slab->free_list;
+    slab->free_list = *(void**)object;
+    return object;
+}
+
+void sysarena_slab_free(ArenaSlab *slab, void *ptr) {
+    if (!slab || !ptr) return;
+    *(void**)ptr = slab->free_list;
+    slab->free_list = ptr;
+}
+
+void sysarena_slab_destroy(ArenaSlab *slab) {
+    if (!slab) return;
+    void *chunk = slab->chunks;
+    while (chunk) {
+        void *next = *(void**)chunk;
+        sysarena_free(slab->manager, chunk);
+        chunk = next;
+    }
+    slab->free_list = NULL;
+    slab->chunks = NULL;
+}
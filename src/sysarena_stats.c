@@ -0,0 +1,62 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+void sysarena_get_stats(ArenaManager *manager, ArenaStats *stats) {
+    if (!manager || !stats) return;
+    const size_t *from = (const size_t*)&manager->stats;
+    size_t *to = (size_t*)stats;
+    for (size_t i = 0; i < sizeof(ArenaStats) / sizeof(size_t); i++) {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    sysarena_lock(manager);
+    stats->largest_free = largest_free(manager);
+    sysarena_unlock(manager);
+}
+
+bool sysarena_snapshot(ArenaManager *manager, ArenaSnapshot *snapshot) {
+    if (!manager || !snapshot || !manager->arenas) return false;
+    *snapshot = (ArenaSnapshot){ 0 };
+    sysarena_lock(manager);
+    for (Arena *a = &manager->arenas[0]; a; a = a->next) {
+        if (a->size == 0) continue;
+        snapshot->blocks++;
+        if (a->in_use) {
+            snapshot->used_blocks++;
+            snapshot->used_bytes += a->size;
+            continue;
+        }
+        snapshot->free_bytes += a->size;
+        snapshot->free_histogram[bin_index(a->size)]++;
+        if (a->size > snapshot->largest_free) snapshot->largest_free = a->size;
+    }
+    for (Arena *a = manager->spare; a; a = a->next) {
+        snapshot->spare_entries++;
+    }
+    sysarena_unlock(manager);
+    return true;
+}
+
+void sysarena_walk(ArenaManager *manager, void (*visit)(const Arena *block, void *context), void *context) {
+    if (!manager || !visit || !manager->arenas) return;
+    // Se visita con el cerrojo tomado: visit no debe llamar al gestor
+    sysarena_lock(manager);
+    for (Arena *a = &manager->arenas[0]; a; a = a->next) {
+        visit(a, context);
+    }
+    sysarena_unlock(manager);
+}
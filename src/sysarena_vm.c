@@ -0,0 +1,139 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+// Respaldo solo para Linux; en otros sistemas (o sin sistema) el archivo queda vacío
+#ifdef __linux__
+
+// MAP_ANONYMOUS, MAP_NORESERVE y madvise no son ISO C: hay que pedirlos
+#define _DEFAULT_SOURCE
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "types.h"
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+// La memoria se hace accesible y se devuelve en pasos de 64 KiB (múltiplo de página)
+#define VM_STEP ((size_t)64 << 10)
+// Cola libre a partir de la cual se devuelve al sistema
+#define VM_TRIM ((size_t)1 << 20)
+
+static inline size_t table_bytes(size_t entries) {
+    return align_up(entries * sizeof(Arena), VM_STEP);
+}
+
+static bool vm_commit(ArenaManager *manager, uint8_t *end) {
+    size_t need = (size_t)(end - manager->initial_memory);
+    if (need <= manager->committed) return true;
+    size_t target = align_up(need, VM_STEP);
+    if (target > manager->initial_size) target = manager->initial_size;
+    if (mprotect(manager->initial_memory + manager->committed, target - manager->committed, PROT_READ | PROT_WRITE)) return false;
+    manager->committed = target;
+    return true;
+}
+
+// Hace accesible el siguiente paso de la tabla y mete sus entradas en la reserva
+static bool vm_grow_table(ArenaManager *manager) {
+    if (manager->max_arenas >= manager->table_capacity) return false;
+    size_t committed = table_bytes(manager->max_arenas);
+    if (mprotect((uint8_t*)manager->arenas + committed, VM_STEP, PROT_READ | PROT_WRITE)) return false;
+
+    size_t old_max = manager->max_arenas;
+    size_t new_max = (committed + VM_STEP) / sizeof(Arena);
+    if (new_max > manager->table_capacity) new_max = manager->table_capacity;
+    manager->max_arenas = new_max;
+    for (size_t i = new_max; i > old_max; i--) {
+        spare_give(manager, &manager->arenas[i - 1]);
+    }
+    return true;
+}
+
+// Si el bloque libre es la cola de la región y es grande, sus páginas vuelven al sistema
+static void vm_release(ArenaManager *manager, Arena *block) {
+    if (block->next) return;
+    size_t keep = align_up((size_t)((uint8_t*)block->base - manager->initial_memory), VM_STEP);
+    if (keep >= manager->committed || manager->committed - keep < VM_TRIM) return;
+    uint8_t *start = manager->initial_memory + keep;
+    madvise(start, manager->committed - keep, MADV_DONTNEED);
+    mprotect(start, manager->committed - keep, PROT_NONE);
+    manager->committed = keep;
+}
+
+// Con hilos esperando al cerrojo, mejor dejar correr al que lo tiene
+static void vm_yield(void) {
+    sched_yield();
+}
+
+static const ArenaBackend vm_backend = { vm_commit, vm_grow_table, vm_release, vm_yield };
+
+bool sysarena_init_vm(ArenaManager *manager, size_t reserve_size, unsigned flags) {
+    // El motor buddy escribe cabeceras en bloques libres que aún no son accesibles
+    if (!manager || reserve_size == 0 || (flags & SYSARENA_ENGINE_BUDDY)) return false;
+    reserve_size = align_up(reserve_size, VM_STEP);
+    size_t capacity = reserve_size / SYSARENA_MIN_BLOCK + 1;
+
+    uint8_t *memory = mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    Arena *table = mmap(NULL, table_bytes(capacity), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (table == MAP_FAILED || mprotect(table, VM_STEP, PROT_READ | PROT_WRITE)) {
+        if (table != MAP_FAILED) munmap(table, table_bytes(capacity));
+        munmap(memory, reserve_size);
+        return false;
+    }
+
+    size_t entries = VM_STEP / sizeof(Arena);
+    if (!sysarena_init_ex(manager, memory, table, reserve_size, entries, flags)) {
+        munmap(table, table_bytes(capacity));
+        munmap(memory, reserve_size);
+        return false;
+    }
+    manager->backend = &vm_backend;
+    manager->committed = 0;
+    manager->table_capacity = capacity;
+    return true;
+}
+
+size_t sysarena_vm_trim(ArenaManager *manager) {
+    if (!manager || manager->backend != &vm_backend) return 0;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t released = 0;
+    sysarena_lock(manager);
+    uint8_t *limit = manager->initial_memory + manager->committed;
+    for (Arena *a = &manager->arenas[0]; a; a = a->next) {
+        if (a->in_use) continue;
+        uint8_t *start = (uint8_t*)align_up((uintptr_t)a->base, page);
+        uint8_t *end = (uint8_t*)(((uintptr_t)a->base + a->size) & ~(page - 1));
+        if (end > limit) end = limit;
+        if (end > start && !madvise(start, (size_t)(end - start), MADV_DONTNEED)) {
+            released += (size_t)(end - start);
+        }
+    }
+    sysarena_unlock(manager);
+    return released;
+}
+
+void sysarena_vm_destroy(ArenaManager *manager) {
+    if (!manager || manager->backend != &vm_backend) return;
+    munmap(manager->arenas, table_bytes(manager->table_capacity));
+    munmap(manager->initial_memory, manager->initial_size);
+    manager->backend = NULL;
+    manager->arenas = NULL;
+    manager->max_arenas = 0;
+    manager->initial_memory = NULL;
+    manager->initial_size = 0;
+    manager->committed = 0;
+}
+
+#endif
@@ -0,0 +1,412 @@
+/* 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+// Pruebas de regresión de sysarena: comprueba los invariantes de la cadena física y de
+// los cajones tras cada operación de una carga aleatoria, para cada motor y política
+//   sysarena_test          (make test)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sysarena.h"
+#include "sysarena_internal.h"
+
+#define REGION ((size_t)1 << 20)
+#define TABLE 1024
+#define SLOTS 256
+#define CHURN_OPS 20000
+#define MT_THREADS 4
+#define MT_OPS 50000
+#define MT_SLOTS 64
+
+static int failures;
+
+#define CHECK(cond, ...)                                          \
+    do {                                                          \
+        if (!(cond)) {                                            \
+            fprintf(stderr, "%s:%d: FALLO: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                         \
+            fputc('\n', stderr);                                  \
+            failures++;                                           \
+            return false;                                         \
+        }                                                         \
+    } while (0)
+
+static uint8_t region[REGION];
+static Arena table[TABLE];
+
+// Generador xorshift: misma secuencia en cada ejecución
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// ---- Invariantes ----
+
+static bool check_chain(ArenaManager *m) {
+    bool buddy = m->flags & SYSARENA_ENGINE_BUDDY;
+    bool eager = !buddy && m->coalesce == SYSARENA_COALESCE_EAGER;
+    size_t covered = 0, free_blocks = 0;
+
+    CHECK(m->arenas[0].prev == NULL, "arenas[0] no es la cabeza");
+    CHECK(m->arenas[0].base == m->initial_memory, "la cadena no empieza en initial_memory");
+    for (Arena *a = &m->arenas[0]; a; a = a->next) {
+        CHECK(is_entry(m, a), "entrada fuera de la tabla");
+        if (a->next) {
+            CHECK(a->next->prev == a, "prev roto tras %p", (void*)a);
+            CHECK((uint8_t*)a->base + a->size == (uint8_t*)a->next->base, "hueco o solape tras %p", (void*)a);
+            CHECK(!eager || !can_coalesce(a, a->next), "dos bloques libres contiguos con fusión inmediata");
+        }
+        covered += a->size;
+        if (a->in_use) {
+            ArenaHeader *header = a->base;
+            CHECK(a->size >= SYSARENA_HEADER + a->used, "bloque ocupado más pequeño que sus datos");
+            CHECK(buddy || header->arena == a, "cabecera que no apunta a su entrada");
+        } else if (a->size > 0) {
+            free_blocks++;
+            size_t offset = (size_t)((uint8_t*)a->base - m->initial_memory);
+            CHECK(!buddy || ((a->size & (a->size - 1)) == 0 && offset % a->size == 0), "bloque buddy desalineado");
+        }
+    }
+    CHECK(covered == m->initial_size, "la cadena cubre %zu de %zu bytes", covered, m->initial_size);
+
+    size_t binned = 0;
+    for (size_t i = 0; i < SYSARENA_BINS; i++) {
+        CHECK(!!(m->bin_map & ((uint64_t)1 << i)) == !!m->bins[i], "bin_map no coincide con el cajón %zu", i);
+        for (Arena *a = m->bins[i]; a; a = a->next_free) {
+            CHECK(!a->in_use && a->size > 0, "bloque ocupado o vacío en el cajón %zu", i);
+            CHECK(bin_index(a->size) == i, "bloque de %zu bytes en el cajón %zu", a->size, i);
+            CHECK(a->next_free == NULL || a->next_free->prev_free == a, "lista del cajón %zu rota", i);
+            binned++;
+        }
+    }
+    CHECK(binned == free_blocks, "%zu bloques en cajones y %zu libres en la cadena", binned, free_blocks);
+
+#ifdef SYSARENA_STATS
+    ArenaStats stats;
+    ArenaSnapshot snapshot;
+    sysarena_get_stats(m, &stats);
+    sysarena_snapshot(m, &snapshot);
+    CHECK(stats.bytes_in_use == snapshot.used_bytes, "bytes_in_use %zu frente a %zu", stats.bytes_in_use, snapshot.used_bytes);
+    CHECK(stats.peak_bytes >= stats.bytes_in_use, "peak_bytes por debajo de bytes_in_use");
+#endif
+    return true;
+}
+
+// ---- Carga aleatoria ----
+
+typedef struct Slot {
+    uint8_t *ptr;
+    size_t size;
+    uint8_t fill;
+} Slot;
+
+static bool check_fill(const Slot *s, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        CHECK(s->ptr[i] == s->fill, "datos corruptos en %p+%zu", (void*)s->ptr, i);
+    }
+    return true;
+}
+
+static size_t random_size(void) {
+    return 1 + rng() % ((rng() & 7) ? 256 : 8192);
+}
+
+static bool churn(ArenaManager *m, const char *name) {
+    Slot slots[SLOTS] = { 0 };
+    void *batch[32];
+    bool ok = true;
+
+    for (size_t op = 0; op < CHURN_OPS && ok; op++) {
+        Slot *s = &slots[rng() % SLOTS];
+        unsigned kind = rng() % 8;
+        bool fresh = false;
+        if (s->ptr && kind < 3) {
+            ok = check_fill(s, s->size) && sysarena_free(m, s->ptr);
+            s->ptr = NULL;
+        } else if (s->ptr && kind < 5) {
+            // El contenido común debe sobrevivir tanto en el sitio como al mover
+            size_t size = random_size();
+            size_t kept = s->size < size ? s->size : size;
+            uint8_t *moved = sysarena_realloc(m, s->ptr, size);
+            if (moved) {
+                s->ptr = moved;
+                ok = check_fill(s, kept);
+                s->size = size;
+                memset(s->ptr, s->fill, size);
+            } else {
+                ok = check_fill(s, s->size);
+            }
+        } else if (!s->ptr && kind < 6) {
+            size_t alignment = (size_t)32 << rng() % 5;
+            s->size = random_size();
+            s->ptr = sysarena_alloc_aligned(m, s->size, alignment);
+            fresh = true;
+            if (s->ptr && (uintptr_t)s->ptr % alignment) {
+                fprintf(stderr, "%s: bloque sin alinear a %zu\n", name, alignment);
+                failures++;
+                ok = false;
+            }
+        } else if (!s->ptr) {
+            s->size = random_size();
+            s->ptr = sysarena_alloc(m, s->size);
+            fresh = true;
+        } else {
+            // Ráfaga: reservar y liberar un lote entero
+            size_t n = sysarena_alloc_batch(m, 48, 1 + rng() % 32, batch);
+            for (size_t i = 0; i < n; i++) memset(batch[i], 0xab, 48);
+            ok = sysarena_free_batch(m, batch, n) == n;
+        }
+        if (fresh && s->ptr) {
+            s->fill = (uint8_t)rng();
+            memset(s->ptr, s->fill, s->size);
+        }
+        ok = ok && check_chain(m);
+    }
+
+    for (size_t i = 0; i < SLOTS && ok; i++) {
+        if (slots[i].ptr) ok = check_fill(&slots[i], slots[i].size) && sysarena_free(m, slots[i].ptr);
+    }
+    sysarena_defragment(m);
+    if (ok && check_chain(m) && !sysarena_is_fully_merged(m)) {
+        fprintf(stderr, "%s: quedan bloques sin fusionar al final\n", name);
+        failures++;
+        ok = false;
+    }
+    printf("%-26s %s\n", name, ok ? "ok" : "FALLO");
+    return ok;
+}
+
+static bool test_engines(void) {
+    static const struct {
+        const char *name;
+        unsigned flags;
+        unsigned coalesce;
+        size_t param;
+    } configs[] = {
+        { "bins/eager", 0, SYSARENA_COALESCE_EAGER, 0 },
+        { "bins/deferred", 0, SYSARENA_COALESCE_DEFERRED, 32 },
+        { "bins/deferred-on-failure", 0, SYSARENA_COALESCE_DEFERRED, 0 },
+        { "bins/incremental", 0, SYSARENA_COALESCE_INCREMENTAL, 4 },
+        { "buddy", SYSARENA_ENGINE_BUDDY, SYSARENA_COALESCE_EAGER, 0 },
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        ArenaManager m;
+        if (!sysarena_init_ex(&m, region, table, REGION, TABLE, configs[i].flags) ||
+            !sysarena_set_coalesce(&m, configs[i].coalesce, configs[i].param)) {
+            fprintf(stderr, "%s: no se pudo inicializar\n", configs[i].name);
+            failures++;
+            ok = false;
+            continue;
+        }
+        ok &= churn(&m, configs[i].name);
+    }
+#ifdef __linux__
+    for (unsigned mode = SYSARENA_COALESCE_EAGER; mode <= SYSARENA_COALESCE_INCREMENTAL; mode += 2) {
+        ArenaManager m;
+        if (!sysarena_init_vm(&m, (size_t)64 << 20, 0) || !sysarena_set_coalesce(&m, mode, 4)) {
+            fprintf(stderr, "vm: no se pudo inicializar\n");
+            failures++;
+            return false;
+        }
+        ok &= churn(&m, mode == SYSARENA_COALESCE_EAGER ? "vm/eager" : "vm/incremental");
+        sysarena_vm_destroy(&m);
+    }
+#endif
+    return ok;
+}
+
+// Con la tabla llena no se entrega un bloque mayor de lo pedido: la reserva falla
+static bool test_table_exhaustion(void) {
+    static Arena small[4];
+    static const unsigned engines[] = { 0, SYSARENA_ENGINE_BUDDY };
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        ArenaManager m;
+        CHECK(sysarena_init_ex(&m, region, small, REGION, 4, engines[e]), "init con tabla de 4");
+        void *ptrs[8];
+        size_t got = 0;
+        while (got < 8 && (ptrs[got] = sysarena_alloc(&m, 16))) got++;
+        void *batch[8];
+        got += sysarena_alloc_batch(&m, 16, 8, batch);
+        ArenaSnapshot snapshot;
+        sysarena_snapshot(&m, &snapshot);
+        CHECK(snapshot.used_bytes < REGION / 2, "%zu bloques ocupan %zu bytes", got, snapshot.used_bytes);
+        CHECK(check_chain(&m), "cadena tras agotar la tabla");
+    }
+    printf("%-26s ok\n", "table-exhaustion");
+    return true;
+}
+
+// sysarena_displacement deja entradas vacías que no deben cortar la fusión
+static bool test_displacement(void) {
+    ArenaManager m;
+    CHECK(sysarena_init(&m, region, table, REGION, TABLE), "init");
+    void *a = sysarena_alloc(&m, 100);
+    void *b = sysarena_alloc(&m, 100);
+    sysarena_free(&m, b);
+    sysarena_displacement(&m, 0);
+    sysarena_free(&m, a);
+    CHECK(check_chain(&m) && sysarena_is_fully_merged(&m), "bloques libres separados por una entrada vacía");
+    printf("%-26s ok\n", "displacement");
+    return true;
+}
+
+static bool test_slab(void) {
+    ArenaManager m;
+    ArenaSlab slab;
+    CHECK(sysarena_init(&m, region, table, REGION, TABLE), "init");
+    CHECK(!sysarena_slab_create(&slab, &m, 32, SIZE_MAX / 16), "slab con trozo desbordado aceptado");
+    CHECK(sysarena_slab_create(&slab, &m, 24, 64), "slab de 24 bytes");
+    for (int i = 0; i < 200; i++) {
+        void *object = sysarena_slab_alloc(&slab);
+        CHECK(object && (uintptr_t)object % SYSARENA_ALIGNMENT == 0, "objeto de slab sin alinear");
+    }
+    sysarena_slab_destroy(&slab);
+    CHECK(sysarena_is_fully_merged(&m), "el slab no devolvió sus trozos");
+    printf("%-26s ok\n", "slab");
+    return true;
+}
+
+static bool test_scratch(void) {
+    // Arena suelta: arena_alloc alinea y arena_free la vacía en O(1)
+    uint8_t buffer[256];
+    Arena bump;
+    poor_arena_init(&bump);
+    CHECK(arena_init(&bump, sizeof buffer, buffer), "arena_init");
+    uint8_t *a = arena_alloc(&bump, 10);
+    uint8_t *b = arena_alloc(&bump, 10);
+    CHECK(a && b && b - a == SYSARENA_ALIGNMENT, "arena_alloc no alinea");
+    CHECK(!arena_alloc(&bump, sizeof buffer), "arena_alloc desbordada");
+    arena_free(&bump);
+    CHECK(arena_alloc(&bump, 10) == a, "arena_free no vacía la arena");
+
+    ArenaManager m;
+    ArenaScratch scratch;
+    ArenaSnapshot snapshot;
+    void *first[64], *again[64];
+    CHECK(sysarena_init(&m, region, table, REGION, TABLE), "init");
+    CHECK(sysarena_scratch_init(&scratch, &m, 1024), "scratch_init");
+    CHECK(sysarena_scratch_alloc(&scratch, 100), "scratch_alloc");
+
+    // 64 * 96 bytes cruzan varios trozos de 1024: el rewind debe repetir la misma secuencia
+    ArenaScratchMark mark = sysarena_scratch_mark(&scratch);
+    for (int i = 0; i < 64; i++) first[i] = sysarena_scratch_alloc(&scratch, 96);
+    sysarena_scratch_rewind(&scratch, mark);
+    for (int i = 0; i < 64; i++) {
+        again[i] = sysarena_scratch_alloc(&scratch, 96);
+        CHECK(again[i] && again[i] == first[i], "rewind no restaura la secuencia (%d)", i);
+    }
+
+    // Los ciclos de reset reutilizan los trozos en vez de pedir otros
+    CHECK(sysarena_snapshot(&m, &snapshot), "snapshot");
+    size_t chunks = snapshot.used_blocks;
+    CHECK(chunks > 1, "la secuencia no cruzó trozos");
+    for (int cycle = 0; cycle < 100; cycle++) {
+        sysarena_scratch_reset(&scratch);
+        for (int i = 0; i < 64; i++) CHECK(sysarena_scratch_alloc(&scratch, 96), "scratch_alloc tras reset");
+    }
+    sysarena_snapshot(&m, &snapshot);
+    CHECK(snapshot.used_blocks == chunks, "los resets crecen de %zu a %zu trozos", chunks, snapshot.used_blocks);
+
+    sysarena_scratch_release(&scratch);
+    CHECK(sysarena_is_fully_merged(&m), "scratch_release no devolvió sus trozos");
+    printf("%-26s ok\n", "scratch");
+    return true;
+}
+
+// ---- Cachés por hilo sobre un gestor compartido ----
+
+#ifdef __linux__
+static ArenaManager shared_manager;
+static void *shared_slots[MT_THREADS][MT_SLOTS];
+
+static void *mt_worker(void *arg) {
+    size_t id = (size_t)arg;
+    uint64_t state = 0x2545f4914f6cdd1dull * (id + 1);
+    ArenaThreadCache cache;
+    uint8_t *mine[MT_SLOTS] = { 0 };
+    sysarena_cache_init(&cache, &shared_manager);
+    for (size_t op = 0; op < MT_OPS; op++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t k = state % MT_SLOTS;
+        if (mine[k]) {
+            // Un tercio se pasa al siguiente hilo para liberarlo allí (o tras destruir esta caché)
+            if (state >> 32 & 1) {
+                void *old = __atomic_exchange_n(&shared_slots[(id + 1) % MT_THREADS][k], mine[k], __ATOMIC_ACQ_REL);
+                if (old) sysarena_cache_free(&cache, old);
+            } else {
+                sysarena_cache_free(&cache, mine[k]);
+            }
+            mine[k] = NULL;
+        } else {
+            size_t size = 1 + (state >> 40) % 3000;
+            mine[k] = (state >> 60) ? sysarena_cache_alloc(&cache, size) : sysarena_alloc(&shared_manager, size);
+            if (mine[k]) memset(mine[k], (int)id, size);
+        }
+    }
+    for (size_t k = 0; k < MT_SLOTS; k++) {
+        if (mine[k]) sysarena_cache_free(&cache, mine[k]);
+    }
+    sysarena_cache_destroy(&cache);
+    return NULL;
+}
+
+static bool test_threads(void) {
+    CHECK(sysarena_init_vm(&shared_manager, (size_t)64 << 20, SYSARENA_THREAD_SAFE), "init_vm");
+    pthread_t threads[MT_THREADS];
+    for (size_t i = 0; i < MT_THREADS; i++) pthread_create(&threads[i], NULL, mt_worker, (void*)i);
+    for (size_t i = 0; i < MT_THREADS; i++) pthread_join(threads[i], NULL);
+
+    // Lo que queda en los huecos es de cachés ya destruidas: debe volver al gestor
+    ArenaThreadCache cache;
+    sysarena_cache_init(&cache, &shared_manager);
+    for (size_t i = 0; i < MT_THREADS; i++) {
+        for (size_t k = 0; k < MT_SLOTS; k++) {
+            if (shared_slots[i][k]) CHECK(sysarena_cache_free(&cache, shared_slots[i][k]), "bloque huérfano rechazado");
+        }
+    }
+    sysarena_cache_destroy(&cache);
+    CHECK(shared_manager.caches == NULL, "quedan cachés registradas");
+    sysarena_defragment(&shared_manager);
+    CHECK(check_chain(&shared_manager) && sysarena_is_fully_merged(&shared_manager), "bloques perdidos tras los hilos");
+    sysarena_vm_destroy(&shared_manager);
+    printf("%-26s ok\n", "threads/cache");
+    return true;
+}
+#endif
+
+int main(void) {
+    test_engines();
+    test_table_exhaustion();
+    test_displacement();
+    test_slab();
+    test_scratch();
+#ifdef __linux__
+    test_threads();
+#endif
+    if (failures) {
+        printf("%d fallos\n", failures);
+        return 1;
+    }
+    puts("todas las pruebas pasan");
+    return 0;
+}
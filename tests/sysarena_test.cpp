@@ -0,0 +1,140 @@
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ Copyright (c) 2025 Guillermo Leira Temes
+*/
+
+// Pruebas de la capa C++ (sysarena.hpp) enlazada contra los objetos de C
+//   sysarena_test_cpp      (make test)
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sysarena.hpp"
+
+static int failures;
+
+#define CHECK(cond, ...)                                               \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            std::fprintf(stderr, "%s:%d: FALLO: ", __FILE__, __LINE__); \
+            std::fprintf(stderr, __VA_ARGS__);                         \
+            std::fputc('\n', stderr);                                  \
+            failures++;                                                \
+            return false;                                              \
+        }                                                              \
+    } while (0)
+
+// Cada nodo del unordered_map ocupa una entrada de la tabla
+using Manager = sysarena::StaticManager<(std::size_t)1 << 20, 8192>;
+using AlignedManager = sysarena::StaticManager<(std::size_t)1 << 20, 1024, 64>;
+
+static Manager manager;
+static AlignedManager aligned;
+
+// Alignment por encima de SYSARENA_ALIGNMENT: también al mover en reallocate
+static bool test_static_manager() {
+    CHECK(aligned, "StaticManager sin inicializar");
+    uint8_t *a = static_cast<uint8_t *>(aligned.allocate(100));
+    void *b = aligned.allocate(100);
+    CHECK(a && b, "allocate");
+    CHECK((uintptr_t)a % 64 == 0 && (uintptr_t)b % 64 == 0, "bloque sin alinear a 64");
+    for (int i = 0; i < 100; i++) a[i] = (uint8_t)i;
+
+    // b ocupa el bloque siguiente: crecer a no puede hacerse en el sitio
+    uint8_t *moved = static_cast<uint8_t *>(aligned.reallocate(a, 4096));
+    CHECK(moved && moved != a, "reallocate no movió el bloque");
+    CHECK((uintptr_t)moved % 64 == 0, "reallocate perdió la alineación de 64");
+    for (int i = 0; i < 100; i++) CHECK(moved[i] == (uint8_t)i, "datos perdidos al mover (%d)", i);
+
+    CHECK(aligned.deallocate(moved) && aligned.deallocate(b), "deallocate");
+    CHECK(sysarena_is_fully_merged(aligned.get()), "quedan bloques sin fusionar");
+    std::printf("%-26s ok\n", "static-manager/align64");
+    return true;
+}
+
+static bool test_memory_resource() {
+    sysarena::MemoryResource resource(manager);
+    {
+        std::pmr::vector<int> values(&resource);
+        for (int i = 0; i < 10000; i++) values.push_back(i);
+        for (int i = 0; i < 10000; i++) CHECK(values[i] == i, "pmr::vector corrupto en %d", i);
+    }
+    CHECK(sysarena_is_fully_merged(manager.get()), "pmr::vector no devolvió su memoria");
+    std::printf("%-26s ok\n", "memory-resource");
+    return true;
+}
+
+static bool test_allocator() {
+    using Map = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                                   sysarena::Allocator<std::pair<const int, int>>>;
+    {
+        Map map(16, std::hash<int>(), std::equal_to<int>(), sysarena::Allocator<std::pair<const int, int>>(manager));
+        for (int i = 0; i < 2000; i++) map.emplace(i, i * 3);
+        for (int i = 0; i < 2000; i += 2) map.erase(i);
+        CHECK(map.size() == 1000, "unordered_map con %zu elementos", map.size());
+        for (int i = 0; i < 2000; i++) {
+            auto it = map.find(i);
+            CHECK(i % 2 ? it != map.end() && it->second == i * 3 : it == map.end(), "clave %d", i);
+        }
+    }
+    CHECK(sysarena_is_fully_merged(manager.get()), "unordered_map no devolvió su memoria");
+    std::printf("%-26s ok\n", "allocator/unordered_map");
+    return true;
+}
+
+struct Point {
+    int x, y;
+};
+
+static bool test_scratch_scope() {
+    {
+        sysarena::Scratch scratch(manager, 1024);
+        CHECK(scratch, "Scratch sin inicializar");
+        Point *origin = scratch.make<Point>(Point{ 1, 2 });
+        CHECK(origin && origin->x == 1 && origin->y == 2, "make");
+
+        // Dentro del ámbito se cruzan varios trozos; al salir se vuelve al mismo punto
+        void *first;
+        {
+            sysarena::ScratchScope scope(scratch);
+            first = scratch.allocate(96);
+            for (int i = 0; i < 64; i++) CHECK(scratch.allocate(96), "allocate en el ámbito");
+        }
+        CHECK(scratch.allocate(96) == first, "ScratchScope no rebobinó la arena");
+        CHECK(origin->x == 1 && origin->y == 2, "el rebobinado pisó datos anteriores");
+    }
+    CHECK(sysarena_is_fully_merged(manager.get()), "Scratch no devolvió sus trozos");
+    std::printf("%-26s ok\n", "scratch-scope");
+    return true;
+}
+
+int main() {
+    if (!manager) {
+        std::fputs("no se pudo inicializar el gestor\n", stderr);
+        return 1;
+    }
+    test_static_manager();
+    test_memory_resource();
+    test_allocator();
+    test_scratch_scope();
+    if (failures) {
+        std::printf("%d fallos\n", failures);
+        return 1;
+    }
+    std::puts("todas las pruebas pasan");
+    return 0;
+}